@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+    Headless benchmark for the analyzer and GUI pipeline.
+
+    Feeds synthetic audio through SingleChannelSampleFifo -> PathProducer ->
+    ResponseCurveComponent::paint into an offscreen juce::Image, for every
+    FFTOrder at realistic editor sizes, and reports the cost of each stage
+    per 60 Hz frame. Nothing is put on screen, so no display server is needed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+struct StageTicks
+{
+    juce::int64 fifoDrain = 0, fft = 0, decibels = 0, pathGeneration = 0, rasterization = 0, pathProducer = 0;
+};
+
+struct EditorSize
+{
+    int width, height;
+};
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int hostBlockSize = 512;
+static constexpr int framesPerSecond = 60;
+static constexpr float negativeInfinity = -48.f;
+
+//Same layout as ZooEQAudioProcessorEditor::resized(): meters on both sides, goniometer right of the curve
+static juce::Rectangle<int> getResponseCurveBounds(EditorSize size)
+{
+    juce::Rectangle<int> bounds(size.width, size.height);
+    bounds.removeFromTop(25);
+    bounds.removeFromTop(5);
+    bounds.removeFromLeft(30);
+    bounds.removeFromRight(30);
+    auto responseArea = bounds.removeFromTop(static_cast<int>(bounds.getHeight() * 32.f / 100.f));
+    responseArea.removeFromRight(responseArea.getHeight());
+    return responseArea.withZeroOrigin();
+}
+
+//Same as ResponseCurveComponent::getAnalysisArea()
+static juce::Rectangle<float> getAnalysisArea(juce::Rectangle<int> bounds)
+{
+    bounds.removeFromTop(12);
+    bounds.removeFromBottom(2);
+    bounds.removeFromLeft(20);
+    bounds.removeFromRight(20);
+    bounds.removeFromTop(4);
+    bounds.removeFromBottom(4);
+    return bounds.toFloat();
+}
+
+static juce::AudioBuffer<float> makeNoise(int numSamples)
+{
+    juce::AudioBuffer<float> noise(2, numSamples);
+    juce::Random random(0x6d794551);
+
+    for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            noise.setSample(ch, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+
+    return noise;
+}
+
+static double ticksToMicroseconds(juce::int64 ticks)
+{
+    return 1.0e6 * juce::Time::highResolutionTicksToSeconds(ticks);
+}
+
+static const char* getOrderName(FFTOrder order)
+{
+    switch (order)
+    {
+        case order2048: return "2048";
+        case order4096: return "4096";
+        case order8192: return "8192";
+    }
+    return "";
+}
+
+//==============================================================================
+/**
+    Runs the stages that PathProducer::process() runs, timing each of them, then
+    the real PathProducer and ResponseCurveComponent on the same audio.
+ */
+static StageTicks runPipeline(EditorSize size, FFTOrder order, const juce::AudioBuffer<float>& noise, int numFrames)
+{
+    StageTicks ticks;
+
+    auto curveBounds = getResponseCurveBounds(size);
+    auto fftBounds = getAnalysisArea(curveBounds);
+
+    // === Stage by stage === //
+    SingleChannelSampleFifo<ZooEQAudioProcessor::BlockType> fifo { Channel::Left };
+    fifo.prepare(ZooEQAudioProcessor::subBlockSize);
+
+    FFTDataGenerator<std::vector<float>> fftDataGenerator;
+    fftDataGenerator.changeOrder(order);
+    const auto fftSize = fftDataGenerator.getFFTSize();
+    const auto binWidth = static_cast<float>(sampleRate / fftSize);
+
+    AnalyserPathGenerator<juce::Path> pathGenerator;
+
+    juce::AudioBuffer<float> monoBuffer(1, fftSize);
+    monoBuffer.clear();
+    juce::AudioBuffer<float> incoming;
+    juce::Path path;
+
+    // === The real thing === //
+    SingleChannelSampleFifo<ZooEQAudioProcessor::BlockType> producerFifo { Channel::Left };
+    producerFifo.prepare(ZooEQAudioProcessor::subBlockSize);
+
+    PathProducer pathProducer(producerFifo);
+    pathProducer.changeOrder(order);
+
+    ZooEQAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, sampleRate, hostBlockSize);
+    processor.prepareToPlay(sampleRate, hostBlockSize);
+
+    ResponseCurveComponent responseCurve(processor);
+    responseCurve.setFFTOrder(order);
+    responseCurve.setSize(curveBounds.getWidth(), curveBounds.getHeight());
+
+    juce::Image image(juce::Image::ARGB, curveBounds.getWidth(), curveBounds.getHeight(), true);
+
+    juce::AudioBuffer<float> hostBlock(2, hostBlockSize);
+    juce::MidiBuffer midi;
+
+    const auto samplesPerFrame = static_cast<int>(sampleRate) / framesPerSecond;
+    int position = 0;
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        //What the audio thread delivers between two timer callbacks
+        for (auto frameEnd = (frame + 1) * samplesPerFrame; position < frameEnd; position += hostBlockSize)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                hostBlock.copyFrom(ch, 0, noise, ch, position % (noise.getNumSamples() - hostBlockSize), hostBlockSize);
+
+            fifo.update(hostBlock);
+            producerFifo.update(hostBlock);
+            processor.processBlock(hostBlock, midi);
+        }
+
+        while (fifo.getNumCompleteBuffersAvailable() > 0)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            if (! fifo.getAudioBuffer(incoming))
+                break;
+
+            auto bufferSize = incoming.getNumSamples();
+            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
+                                              monoBuffer.getReadPointer(0, bufferSize),
+                                              monoBuffer.getNumSamples() - bufferSize);
+            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - bufferSize),
+                                              incoming.getReadPointer(0, 0),
+                                              bufferSize);
+
+            auto drained = juce::Time::getHighResolutionTicks();
+            fftDataGenerator.performFFT(monoBuffer);
+
+            auto transformed = juce::Time::getHighResolutionTicks();
+            fftDataGenerator.convertToDecibels(negativeInfinity);
+
+            auto converted = juce::Time::getHighResolutionTicks();
+            pathGenerator.generatePath(fftDataGenerator.getRenderData(), fftBounds, fftSize, binWidth, negativeInfinity);
+            while (pathGenerator.getNumPathsAvailable() > 0)
+                pathGenerator.getPath(path);
+
+            auto generated = juce::Time::getHighResolutionTicks();
+
+            ticks.fifoDrain += drained - start;
+            ticks.fft += transformed - drained;
+            ticks.decibels += converted - transformed;
+            ticks.pathGeneration += generated - converted;
+        }
+
+        auto start = juce::Time::getHighResolutionTicks();
+        pathProducer.process(fftBounds, sampleRate);
+        ticks.pathProducer += juce::Time::getHighResolutionTicks() - start;
+
+        //The component analyses the processor's own FIFOs; only its paint() is timed
+        responseCurve.timerCallback();
+
+        start = juce::Time::getHighResolutionTicks();
+        {
+            juce::Graphics g(image);
+            responseCurve.paint(g);
+        }
+        ticks.rasterization += juce::Time::getHighResolutionTicks() - start;
+    }
+
+    processor.releaseResources();
+    return ticks;
+}
+
+static juce::var toVar(EditorSize size, FFTOrder order, const StageTicks& ticks, int numFrames)
+{
+    auto perFrame = [numFrames](juce::int64 t) { return ticksToMicroseconds(t) / numFrames; };
+
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("editorWidth", size.width);
+    obj->setProperty("editorHeight", size.height);
+    obj->setProperty("fftSize", 1 << order);
+    obj->setProperty("frames", numFrames);
+
+    auto* us = new juce::DynamicObject();
+    us->setProperty("fifoDrain", perFrame(ticks.fifoDrain));
+    us->setProperty("fft", perFrame(ticks.fft));
+    us->setProperty("decibels", perFrame(ticks.decibels));
+    us->setProperty("pathGeneration", perFrame(ticks.pathGeneration));
+    us->setProperty("rasterization", perFrame(ticks.rasterization));
+    us->setProperty("pathProducer", perFrame(ticks.pathProducer));
+    obj->setProperty("microsecondsPerFrame", juce::var(us));
+
+    return juce::var(obj);
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: myEQAnalyzerBenchmarks [options]" << std::endl
+              << std::endl
+              << "  --json <file>     Write the results as JSON" << std::endl
+              << "  --seconds <s>     Seconds of 60 Hz frames per case (default: 2)" << std::endl
+              << "  --cpu <n>         Core to pin the benchmark thread to (default: 0)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        auto seconds = 2.0;
+        if (args.containsOption("--seconds"))
+            seconds = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+
+        auto cpu = 0;
+        if (args.containsOption("--cpu"))
+        {
+            cpu = args.getValueForOption("--cpu").getIntValue();
+
+            //The affinity mask is 32 bits wide
+            if (cpu < 0 || cpu > 31)
+                juce::ConsoleApplication::fail("--cpu must be between 0 and 31");
+        }
+
+        juce::Thread::setCurrentThreadAffinityMask(static_cast<juce::uint32>(1) << cpu);
+
+        const auto numFrames = juce::jmax(1, static_cast<int>(seconds * framesPerSecond));
+        const auto noise = makeNoise(static_cast<int>(sampleRate));
+
+        const std::vector<EditorSize> sizes { { 600, 400 }, { 900, 600 }, { 1200, 800 }, { 1920, 1080 } };
+        const std::vector<FFTOrder> orders { order2048, order4096, order8192 };
+
+        juce::Array<juce::var> results;
+
+        std::cout << "editor      fft    drain     fft       dB        path      raster    PathProducer  (us/frame)" << std::endl;
+
+        for (auto size : sizes)
+        {
+            for (auto order : orders)
+            {
+                auto ticks = runPipeline(size, order, noise, numFrames);
+                results.add(toVar(size, order, ticks, numFrames));
+
+                auto column = [numFrames](juce::int64 t)
+                {
+                    return juce::String(ticksToMicroseconds(t) / numFrames, 1).paddedRight(' ', 10);
+                };
+
+                std::cout << (juce::String(size.width) + "x" + juce::String(size.height)).paddedRight(' ', 12)
+                          << juce::String(getOrderName(order)).paddedRight(' ', 7)
+                          << column(ticks.fifoDrain)
+                          << column(ticks.fft)
+                          << column(ticks.decibels)
+                          << column(ticks.pathGeneration)
+                          << column(ticks.rasterization)
+                          << column(ticks.pathProducer)
+                          << std::endl;
+            }
+        }
+
+        if (args.containsOption("--json"))
+        {
+            auto* root = new juce::DynamicObject();
+            root->setProperty("cpuModel", juce::SystemStats::getCpuModel());
+            root->setProperty("results", results);
+
+            auto file = args.getFileForOption("--json");
+            if (! file.replaceWithText(juce::JSON::toString(juce::var(root))))
+                juce::ConsoleApplication::fail("Cannot write " + file.getFullPathName());
+        }
+
+        return 0;
+    });
+}
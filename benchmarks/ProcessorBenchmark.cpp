@@ -0,0 +1,490 @@
+/*
+  ==============================================================================
+
+    Microbenchmarks for the audio path.
+
+    Drives ZooEQAudioProcessor::processBlock and a raw pair of MonoChains over
+    a matrix of block sizes, sample rates, slopes, bypass states and static vs.
+    automated parameters, and reports ns/sample (per stereo frame) with
+    repeated runs on a pinned core. Results can be written as JSON so that
+    different builds can be compared.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ResponseCheck.h"
+
+enum class BenchmarkTarget
+{
+    ProcessBlock,
+    MonoChain
+};
+
+struct BenchmarkCase
+{
+    BenchmarkTarget target;
+    int blockSize;
+    double sampleRate;
+    Slope lowCutSlope, highCutSlope;
+    bool lowCutBypassed, peakBypassed, highCutBypassed;
+    bool automated;
+};
+
+struct BenchmarkSettings
+{
+    int runs = 7;
+    int warmupRuns = 1;
+    double secondsPerRun = 0.25;
+    int cpu = 0;
+    std::optional<InstructionSet> instructionSet;
+    FilterEngine engine = FilterEngine::recursive;
+    FilterTopology topology = FilterTopology::series;
+    bool truePeak = false;
+    bool midSide = false;
+
+    std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    std::vector<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    std::vector<Slope> slopes { Slope_12, Slope_24, Slope_36, Slope_48 };
+    std::vector<int> bypassMasks { 0, 1, 2, 3, 4, 5, 6, 7 };
+    std::vector<BenchmarkTarget> targets { BenchmarkTarget::ProcessBlock, BenchmarkTarget::MonoChain };
+};
+
+struct Statistics
+{
+    double median = 0, mean = 0, min = 0, stdDev = 0;
+};
+
+static Statistics computeStatistics(std::vector<double> values)
+{
+    Statistics stats;
+    if (values.empty())
+        return stats;
+
+    std::sort(values.begin(), values.end());
+
+    auto n = values.size();
+    stats.median = n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+    stats.min = values.front();
+
+    for (auto v : values)
+        stats.mean += v;
+    stats.mean /= static_cast<double>(n);
+
+    for (auto v : values)
+        stats.stdDev += (v - stats.mean) * (v - stats.mean);
+    stats.stdDev = n > 1 ? std::sqrt(stats.stdDev / static_cast<double>(n - 1)) : 0.0;
+
+    return stats;
+}
+
+static int slopeToDecibels(Slope slope)
+{
+    return 12 * (static_cast<int>(slope) + 1);
+}
+
+//==============================================================================
+static ChainSettings makeChainSettings(const BenchmarkCase& c)
+{
+    ChainSettings settings;
+    settings.lowCutFreq = 80.f;
+    settings.highCutFreq = 12000.f;
+    settings.peakFreq = 750.f;
+    settings.peakGainInDecibels = 6.f;
+    settings.peakQuality = 1.f;
+    settings.lowCutSlope = c.lowCutSlope;
+    settings.highCutSlope = c.highCutSlope;
+    settings.lowCutBypassed = c.lowCutBypassed;
+    settings.peakBypassed = c.peakBypassed;
+    settings.highCutBypassed = c.highCutBypassed;
+    return settings;
+}
+
+//The automated cases sweep the peak around its static setting, once per block
+static float automatedPeakFreq(int blockIndex)
+{
+    return 750.f * std::pow(2.f, 2.f * std::sin(0.05f * static_cast<float>(blockIndex)));
+}
+
+static void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float value)
+{
+    auto* param = apvts.getParameter(id);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+static void applyChainSettings(juce::AudioProcessorValueTreeState& apvts, const ChainSettings& settings)
+{
+    setParameter(apvts, "LowCut Freq", settings.lowCutFreq);
+    setParameter(apvts, "HighCut Freq", settings.highCutFreq);
+    setParameter(apvts, "Peak Freq", settings.peakFreq);
+    setParameter(apvts, "Peak Gain", settings.peakGainInDecibels);
+    setParameter(apvts, "Peak Quality", settings.peakQuality);
+    setParameter(apvts, "LowCut Slope", static_cast<float>(settings.lowCutSlope));
+    setParameter(apvts, "HighCut Slope", static_cast<float>(settings.highCutSlope));
+    setParameter(apvts, "LowCut Bypassed", settings.lowCutBypassed ? 1.f : 0.f);
+    setParameter(apvts, "Peak Bypassed", settings.peakBypassed ? 1.f : 0.f);
+    setParameter(apvts, "HighCut Bypassed", settings.highCutBypassed ? 1.f : 0.f);
+}
+
+//Same as what the processor does in updateFilters(), for the raw chain
+static void updateChain(MonoChain& chain, const ChainSettings& settings, double sampleRate)
+{
+    chain.setBypassed<ChainPositions::LowCut>(settings.lowCutBypassed);
+    chain.setBypassed<ChainPositions::Peak>(settings.peakBypassed);
+    chain.setBypassed<ChainPositions::HighCut>(settings.highCutBypassed);
+
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makePeakCoefficients(settings, sampleRate));
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), makeLowCutCoefficients(settings, sampleRate), settings.lowCutSlope);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), makeHighCutCoefficients(settings, sampleRate), settings.highCutSlope);
+}
+
+static juce::AudioBuffer<float> makeNoise(int numSamples)
+{
+    juce::AudioBuffer<float> noise(2, numSamples);
+    juce::Random random(0x6d794551);
+
+    for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            noise.setSample(ch, i, 0.25f * (2.f * random.nextFloat() - 1.f));
+
+    return noise;
+}
+
+//==============================================================================
+/**
+    Times processBlock() calls only: copying the input in and the host-side
+    parameter automation are outside of the measured region.
+ */
+static std::vector<double> runProcessBlock(const BenchmarkCase& c, const BenchmarkSettings& s, const juce::AudioBuffer<float>& noise)
+{
+    ZooEQAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, c.sampleRate, c.blockSize);
+    applyChainSettings(processor.apvts, makeChainSettings(c));
+    
+    //The side gets the same bands, so mid/side runs as many sections as stereo does
+    if (s.midSide)
+        for (size_t i = 0; i < sideChainParameterIDs.size(); ++i)
+            setParameter(processor.apvts, sideChainParameterIDs[i],
+                         processor.apvts.getRawParameterValue(chainParameterIDs[i])->load());
+    
+    processor.forceInstructionSet(s.instructionSet);
+    processor.setFilterEngine(false, s.engine);
+    processor.setFilterTopology(s.topology);
+    setParameter(processor.apvts, "TruePeak Enable", s.truePeak ? 1.0f : 0.0f);
+    setParameter(processor.apvts, "MidSide Enable", s.midSide ? 1.0f : 0.0f);
+    processor.prepareToPlay(c.sampleRate, c.blockSize);
+
+    juce::AudioBuffer<float> buffer(2, c.blockSize);
+    juce::MidiBuffer midi;
+
+    auto numBlocks = noise.getNumSamples() / c.blockSize;
+    std::vector<double> nsPerSample;
+
+    for (int run = -s.warmupRuns; run < s.runs; ++run)
+    {
+        juce::int64 ticks = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom(ch, 0, noise, ch, block * c.blockSize, c.blockSize);
+
+            if (c.automated)
+                setParameter(processor.apvts, "Peak Freq", automatedPeakFreq(block));
+
+            auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        if (run >= 0)
+            nsPerSample.push_back(1.0e9 * juce::Time::highResolutionTicksToSeconds(ticks) / (numBlocks * c.blockSize));
+    }
+
+    processor.releaseResources();
+    return nsPerSample;
+}
+
+static std::vector<double> runMonoChain(const BenchmarkCase& c, const BenchmarkSettings& s, const juce::AudioBuffer<float>& noise)
+{
+    MonoChain leftChain, rightChain;
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = static_cast<juce::uint32>(c.blockSize);
+    spec.numChannels = 1;
+    spec.sampleRate = c.sampleRate;
+
+    leftChain.prepare(spec);
+    rightChain.prepare(spec);
+
+    auto settings = makeChainSettings(c);
+    updateChain(leftChain, settings, c.sampleRate);
+    updateChain(rightChain, settings, c.sampleRate);
+
+    juce::AudioBuffer<float> buffer(2, c.blockSize);
+
+    auto numBlocks = noise.getNumSamples() / c.blockSize;
+    std::vector<double> nsPerSample;
+
+    for (int run = -s.warmupRuns; run < s.runs; ++run)
+    {
+        juce::int64 ticks = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom(ch, 0, noise, ch, block * c.blockSize, c.blockSize);
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            //The raw chain has no parameter handling, so automation means redesigning every block
+            if (c.automated)
+            {
+                settings.peakFreq = automatedPeakFreq(block);
+                updateChain(leftChain, settings, c.sampleRate);
+                updateChain(rightChain, settings, c.sampleRate);
+            }
+
+            juce::dsp::AudioBlock<float> audioBlock(buffer);
+            auto leftBlock = audioBlock.getSingleChannelBlock(0);
+            auto rightBlock = audioBlock.getSingleChannelBlock(1);
+
+            leftChain.process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
+            rightChain.process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        if (run >= 0)
+            nsPerSample.push_back(1.0e9 * juce::Time::highResolutionTicksToSeconds(ticks) / (numBlocks * c.blockSize));
+    }
+
+    return nsPerSample;
+}
+
+//==============================================================================
+static std::vector<BenchmarkCase> makeCases(const BenchmarkSettings& s)
+{
+    std::vector<BenchmarkCase> cases;
+
+    for (auto target : s.targets)
+        for (auto sampleRate : s.sampleRates)
+            for (auto blockSize : s.blockSizes)
+                for (auto lowCutSlope : s.slopes)
+                    for (auto highCutSlope : s.slopes)
+                        for (auto bypassMask : s.bypassMasks)
+                            for (auto automated : { false, true })
+                                cases.push_back({ target,
+                                                  blockSize,
+                                                  sampleRate,
+                                                  lowCutSlope,
+                                                  highCutSlope,
+                                                  (bypassMask & 1) != 0,
+                                                  (bypassMask & 2) != 0,
+                                                  (bypassMask & 4) != 0,
+                                                  automated });
+    return cases;
+}
+
+static juce::var toVar(const BenchmarkCase& c, const Statistics& stats, int runs)
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("target", c.target == BenchmarkTarget::ProcessBlock ? "processBlock" : "MonoChain");
+    obj->setProperty("blockSize", c.blockSize);
+    obj->setProperty("sampleRate", c.sampleRate);
+    obj->setProperty("lowCutSlope", slopeToDecibels(c.lowCutSlope));
+    obj->setProperty("highCutSlope", slopeToDecibels(c.highCutSlope));
+    obj->setProperty("lowCutBypassed", c.lowCutBypassed);
+    obj->setProperty("peakBypassed", c.peakBypassed);
+    obj->setProperty("highCutBypassed", c.highCutBypassed);
+    obj->setProperty("automated", c.automated);
+    obj->setProperty("runs", runs);
+
+    auto* ns = new juce::DynamicObject();
+    ns->setProperty("median", stats.median);
+    ns->setProperty("mean", stats.mean);
+    ns->setProperty("min", stats.min);
+    ns->setProperty("stdDev", stats.stdDev);
+    obj->setProperty("nsPerSample", juce::var(ns));
+
+    return juce::var(obj);
+}
+
+static juce::var describeMachine(const BenchmarkSettings& s)
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("cpuModel", juce::SystemStats::getCpuModel());
+    obj->setProperty("numCpus", juce::SystemStats::getNumCpus());
+    obj->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    obj->setProperty("pinnedCpu", s.cpu);
+    obj->setProperty("engine", s.engine == FilterEngine::blockStateSpace ? "block"
+                             : s.engine == FilterEngine::stateVariable ? "svf" : "recursive");
+    obj->setProperty("topology", s.topology == FilterTopology::parallel ? "parallel" : "series");
+    obj->setProperty("truePeak", s.truePeak);
+    obj->setProperty("midSide", s.midSide);
+    obj->setProperty("kernels", (s.instructionSet.has_value() ? selectDspKernels(*s.instructionSet) : selectDspKernels()).name);
+   #if JUCE_DEBUG
+    obj->setProperty("build", "Debug");
+   #else
+    obj->setProperty("build", "Release");
+   #endif
+    obj->setProperty("juceVersion", juce::SystemStats::getJUCEVersion());
+    return juce::var(obj);
+}
+
+template<typename T, typename Parser>
+static std::vector<T> parseList(const juce::String& text, Parser parse)
+{
+    std::vector<T> values;
+    for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+        values.push_back(parse(token.trim()));
+    return values;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: myEQBenchmarks [options]" << std::endl
+              << std::endl
+              << "  --json <file>           Write the results as JSON" << std::endl
+              << "  --runs <n>              Measured runs per case (default: 7)" << std::endl
+              << "  --seconds <s>           Audio processed per run (default: 0.25)" << std::endl
+              << "  --cpu <n>               Core to pin the benchmark thread to (default: 0)" << std::endl
+              << "  --target <t>            processBlock, chain or all (default: all)" << std::endl
+              << "  --block-sizes <list>    e.g. 64,512,4096 (default: 16..4096)" << std::endl
+              << "  --sample-rates <list>   e.g. 48000,96000 (default: 44100..192000)" << std::endl
+              << "  --slopes <list>         e.g. 12,48 (default: 12,24,36,48)" << std::endl
+              << "  --kernels <isa>         Force scalar, sse2, avx2, avx512 or neon kernels (default: best for this CPU)" << std::endl
+              << "  --engine <e>            processBlock filter engine: recursive, block or svf (default: recursive)" << std::endl
+              << "  --topology <t>          processBlock filter topology: series or parallel (default: series)" << std::endl
+              << "  --true-peak             Enable the true-peak output meter in processBlock" << std::endl
+              << "  --mid-side              Run processBlock in mid/side mode, with the same bands on both" << std::endl
+              << "  --quick                 A reduced matrix for a fast sanity check" << std::endl
+              << std::endl
+              << "Response checks (instead of timing):" << std::endl
+              << std::endl
+              << "  --write-responses <file>  Render the response grid and store it as golden JSON" << std::endl
+              << "  --check-responses <file>  Compare the response grid against a golden file" << std::endl
+              << "  --tolerance <dB>          Allowed deviation from the golden file (default: 0.01)" << std::endl
+              << "  --bit-exact               Check processBlock() against the reference MonoChain" << std::endl
+              << "                            (with --engine block: no further from exact than the recursion)" << std::endl
+              << "                            (with --engine svf: within 1e-3 of exact)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        if (isResponseCheckRequested(args))
+            return runResponseChecks(args);
+        
+        BenchmarkSettings settings;
+
+        if (args.containsOption("--quick"))
+        {
+            settings.runs = 3;
+            settings.blockSizes = { 64, 512, 4096 };
+            settings.sampleRates = { 48000.0 };
+            settings.slopes = { Slope_12, Slope_48 };
+            settings.bypassMasks = { 0 };
+        }
+
+        if (args.containsOption("--runs"))
+            settings.runs = juce::jmax(1, args.getValueForOption("--runs").getIntValue());
+
+        if (args.containsOption("--seconds"))
+            settings.secondsPerRun = juce::jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+        if (args.containsOption("--cpu"))
+        {
+            settings.cpu = args.getValueForOption("--cpu").getIntValue();
+
+            //The affinity mask is 32 bits wide
+            if (settings.cpu < 0 || settings.cpu > 31)
+                juce::ConsoleApplication::fail("--cpu must be between 0 and 31");
+        }
+
+        settings.instructionSet = getForcedInstructionSet(args);
+        settings.engine = getFilterEngine(args);
+        settings.topology = getFilterTopology(args);
+        settings.truePeak = args.containsOption("--true-peak");
+        settings.midSide = args.containsOption("--mid-side");
+
+        if (args.containsOption("--target"))
+        {
+            auto target = args.getValueForOption("--target");
+            if (target == "processBlock")
+                settings.targets = { BenchmarkTarget::ProcessBlock };
+            else if (target == "chain")
+                settings.targets = { BenchmarkTarget::MonoChain };
+            else if (target != "all")
+                juce::ConsoleApplication::fail("Unknown target: " + target);
+        }
+
+        if (args.containsOption("--block-sizes"))
+            settings.blockSizes = parseList<int>(args.getValueForOption("--block-sizes"),
+                                                 [](const juce::String& t) { return juce::jlimit(1, 8192, t.getIntValue()); });
+
+        if (args.containsOption("--sample-rates"))
+            settings.sampleRates = parseList<double>(args.getValueForOption("--sample-rates"),
+                                                     [](const juce::String& t) { return t.getDoubleValue(); });
+
+        if (args.containsOption("--slopes"))
+            settings.slopes = parseList<Slope>(args.getValueForOption("--slopes"),
+                                               [](const juce::String& t) { return static_cast<Slope>(juce::jlimit(0, 3, t.getIntValue() / 12 - 1)); });
+
+        //Pin ourselves to one core so that the scheduler doesn't add noise between runs
+        juce::Thread::setCurrentThreadAffinityMask(static_cast<juce::uint32>(1) << settings.cpu);
+        juce::ScopedNoDenormals noDenormals;
+
+        auto cases = makeCases(settings);
+        juce::Array<juce::var> results;
+
+        for (size_t i = 0; i < cases.size(); ++i)
+        {
+            auto& c = cases[i];
+
+            //Same amount of audio for every block size, rounded to whole blocks
+            auto numSamples = static_cast<int>(settings.secondsPerRun * c.sampleRate);
+            numSamples = juce::jmax(1, numSamples / c.blockSize) * c.blockSize;
+            auto noise = makeNoise(numSamples);
+
+            auto nsPerSample = c.target == BenchmarkTarget::ProcessBlock ? runProcessBlock(c, settings, noise)
+                                                                         : runMonoChain(c, settings, noise);
+            auto stats = computeStatistics(nsPerSample);
+            results.add(toVar(c, stats, settings.runs));
+
+            std::cout << "[" << (i + 1) << "/" << cases.size() << "] "
+                      << (c.target == BenchmarkTarget::ProcessBlock ? "processBlock" : "MonoChain   ")
+                      << " block " << c.blockSize
+                      << " @ " << c.sampleRate
+                      << " slopes " << slopeToDecibels(c.lowCutSlope) << "/" << slopeToDecibels(c.highCutSlope)
+                      << " bypass " << (c.lowCutBypassed ? "L" : "-") << (c.peakBypassed ? "P" : "-") << (c.highCutBypassed ? "H" : "-")
+                      << (c.automated ? " automated" : " static   ")
+                      << ": " << juce::String(stats.median, 2) << " ns/sample (+/- " << juce::String(stats.stdDev, 2) << ")"
+                      << std::endl;
+        }
+
+        if (args.containsOption("--json"))
+        {
+            auto* root = new juce::DynamicObject();
+            root->setProperty("machine", describeMachine(settings));
+            root->setProperty("results", results);
+
+            auto file = args.getFileForOption("--json");
+            if (! file.replaceWithText(juce::JSON::toString(juce::var(root))))
+                juce::ConsoleApplication::fail("Cannot write " + file.getFullPathName());
+        }
+
+        return 0;
+    });
+}
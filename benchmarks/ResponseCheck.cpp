@@ -0,0 +1,663 @@
+/*
+  ==============================================================================
+
+    Frequency-response regression checks for the DSP core.
+
+  ==============================================================================
+*/
+
+#include "ResponseCheck.h"
+#include "PluginProcessor.h"
+
+struct ResponseCase
+{
+    ChainSettings settings;
+    double sampleRate;
+};
+
+struct RenderedResponse
+{
+    std::vector<float> impulse;         //processBlock() output, left channel
+    std::vector<float> referenceImpulse; //raw MonoChain output
+    std::vector<double> exactImpulse;    //the MonoChain's sections run in double precision
+    bool parallelForm = false;           //processBlock() ran the parallel sections, not the cascade
+    std::vector<double> magnitudeDb;
+    std::vector<double> sweepDb;
+    std::vector<double> magnitudeSlackDb; //see measureRoundingSlack(), only when writing golden responses
+    std::vector<double> sweepSlackDb;
+};
+
+static constexpr int blockSize = 480; //deliberately not a power of two
+static constexpr int impulseLength = 8192;
+static constexpr int numMagnitudePoints = 64;
+static constexpr int numSweepSegments = 32;
+static constexpr double defaultToleranceDb = 0.01;
+static constexpr double comparisonFloorDb = -100.0; //deep stopbands are rounding noise
+static constexpr double comparisonCeilingDb = 100.0; //and anything this loud has blown up
+static constexpr int slackSteps = 4; //rounding steps the feedback coefficients are nudged by for the slack
+
+//==============================================================================
+static std::vector<ResponseCase> makeResponseCases()
+{
+    std::vector<ResponseCase> cases;
+    const std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+
+    //Every slope and bypass combination at a typical setting...
+    for (auto sampleRate : sampleRates)
+        for (int lowCutSlope = Slope_12; lowCutSlope <= Slope_48; ++lowCutSlope)
+            for (int highCutSlope = Slope_12; highCutSlope <= Slope_48; ++highCutSlope)
+                for (int bypassMask = 0; bypassMask < 8; ++bypassMask)
+                {
+                    ChainSettings settings;
+                    settings.lowCutFreq = 80.f;
+                    settings.highCutFreq = 12000.f;
+                    settings.peakFreq = 750.f;
+                    settings.peakGainInDecibels = 6.f;
+                    settings.peakQuality = 1.f;
+                    settings.lowCutSlope = static_cast<Slope>(lowCutSlope);
+                    settings.highCutSlope = static_cast<Slope>(highCutSlope);
+                    settings.lowCutBypassed = (bypassMask & 1) != 0;
+                    settings.peakBypassed = (bypassMask & 2) != 0;
+                    settings.highCutBypassed = (bypassMask & 4) != 0;
+                    cases.push_back({ settings, sampleRate });
+                }
+
+    //...plus a fixed pseudo-random spread over the whole parameter ranges
+    juce::Random random(0x676f6c64);
+    auto logUniform = [&random](float low, float high)
+    {
+        return std::round(low * std::pow(high / low, random.nextFloat()));
+    };
+
+    for (int i = 0; i < 512; ++i)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = logUniform(20.f, 20000.f);
+        settings.highCutFreq = logUniform(20.f, 20000.f);
+        settings.peakFreq = logUniform(20.f, 20000.f);
+        settings.peakGainInDecibels = -24.f + 0.5f * static_cast<float>(random.nextInt(97));
+        settings.peakQuality = 0.1f + 0.5f * static_cast<float>(random.nextInt(20));
+        settings.lowCutSlope = static_cast<Slope>(random.nextInt(4));
+        settings.highCutSlope = static_cast<Slope>(random.nextInt(4));
+        cases.push_back({ settings, sampleRates[static_cast<size_t>(random.nextInt(static_cast<int>(sampleRates.size())))] });
+    }
+
+    return cases;
+}
+
+static void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float value)
+{
+    auto* param = apvts.getParameter(id);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+static void applyChainSettings(juce::AudioProcessorValueTreeState& apvts, const ChainSettings& settings)
+{
+    setParameter(apvts, "LowCut Freq", settings.lowCutFreq);
+    setParameter(apvts, "HighCut Freq", settings.highCutFreq);
+    setParameter(apvts, "Peak Freq", settings.peakFreq);
+    setParameter(apvts, "Peak Gain", settings.peakGainInDecibels);
+    setParameter(apvts, "Peak Quality", settings.peakQuality);
+    setParameter(apvts, "LowCut Slope", static_cast<float>(settings.lowCutSlope));
+    setParameter(apvts, "HighCut Slope", static_cast<float>(settings.highCutSlope));
+    setParameter(apvts, "LowCut Bypassed", settings.lowCutBypassed ? 1.f : 0.f);
+    setParameter(apvts, "Peak Bypassed", settings.peakBypassed ? 1.f : 0.f);
+    setParameter(apvts, "HighCut Bypassed", settings.highCutBypassed ? 1.f : 0.f);
+}
+
+//==============================================================================
+static void processThroughProcessor(ZooEQAudioProcessor& processor, juce::AudioBuffer<float>& signal)
+{
+    juce::AudioBuffer<float> block(2, blockSize);
+    juce::MidiBuffer midi;
+
+    for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+    {
+        auto numSamples = juce::jmin(blockSize, signal.getNumSamples() - start);
+        block.setSize(2, numSamples, false, false, true);
+
+        for (int ch = 0; ch < 2; ++ch)
+            block.copyFrom(ch, 0, signal, ch, start, numSamples);
+
+        processor.processBlock(block, midi);
+
+        for (int ch = 0; ch < 2; ++ch)
+            signal.copyFrom(ch, start, block, ch, 0, numSamples);
+    }
+}
+
+static void designReferenceChain(MonoChain& chain, const ChainSettings& settings, double sampleRate)
+{
+    chain.setBypassed<ChainPositions::LowCut>(settings.lowCutBypassed);
+    chain.setBypassed<ChainPositions::Peak>(settings.peakBypassed);
+    chain.setBypassed<ChainPositions::HighCut>(settings.highCutBypassed);
+
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makePeakFilter(settings, sampleRate));
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), makeLowCutFilter(settings, sampleRate), settings.lowCutSlope);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), makeHighCutFilter(settings, sampleRate), settings.highCutSlope);
+}
+
+/**
+    Runs the chain the way processBlock() runs its filters: each block split into sub-blocks,
+    with denormals flushed. The filters snap their state to zero at the end of every call, so
+    the impulse tails only stay bit-exact if the calls end on the same samples.
+ */
+static void processThroughMonoChain(MonoChain& chain, double sampleRate, std::vector<float>& signal)
+{
+    juce::ScopedNoDenormals noDenormals;
+    constexpr auto subBlockSize = static_cast<size_t>(ZooEQAudioProcessor::subBlockSize);
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = static_cast<juce::uint32>(subBlockSize);
+    spec.numChannels = 1;
+    spec.sampleRate = sampleRate;
+
+    chain.prepare(spec);
+
+    for (size_t start = 0; start < signal.size(); start += blockSize)
+    {
+        const auto end = juce::jmin(start + static_cast<size_t>(blockSize), signal.size());
+
+        for (auto subBlock = start; subBlock < end; subBlock += subBlockSize)
+        {
+            float* channels[] = { signal.data() + subBlock };
+            juce::dsp::AudioBlock<float> block(channels, 1, juce::jmin(subBlockSize, end - subBlock));
+            chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+    }
+}
+
+/** Moves the feedback coefficients of every section by slackSteps rounding steps, a1 and a2 each in their own direction */
+static void nudgeFeedbackCoefficients(MonoChain& chain, float a1Direction, float a2Direction)
+{
+    auto nudgeSection = [a1Direction, a2Direction](Filter& filter)
+    {
+        auto* c = filter.coefficients->getRawCoefficients();
+
+        for (int step = 0; step < slackSteps; ++step)
+        {
+            c[3] = std::nextafter(c[3], a1Direction * std::numeric_limits<float>::infinity());
+            c[4] = std::nextafter(c[4], a2Direction * std::numeric_limits<float>::infinity());
+        }
+    };
+
+    auto nudgeCutFilter = [&nudgeSection](CutFilter& cut)
+    {
+        nudgeSection(cut.get<0>());
+        nudgeSection(cut.get<1>());
+        nudgeSection(cut.get<2>());
+        nudgeSection(cut.get<3>());
+    };
+
+    nudgeCutFilter(chain.get<ChainPositions::LowCut>());
+    nudgeSection(chain.get<ChainPositions::Peak>());
+    nudgeCutFilter(chain.get<ChainPositions::HighCut>());
+}
+
+//The same sections as processThroughMonoChain(), without float rounding in the recursion
+static void processInDouble(const ChainSettings& settings, double sampleRate, std::vector<double>& signal)
+{
+    MonoChain chain;
+    designReferenceChain(chain, settings, sampleRate);
+
+    auto processSection = [&signal](const Filter& filter)
+    {
+        auto* c = filter.coefficients->getRawCoefficients();
+        double s1 = 0, s2 = 0;
+
+        for (auto& sample : signal)
+        {
+            auto input = sample;
+            auto output = input * c[0] + s1;
+            s1 = input * c[1] - output * c[3] + s2;
+            s2 = input * c[2] - output * c[4];
+            sample = output;
+        }
+    };
+
+    auto processCutFilter = [&processSection](const CutFilter& cut)
+    {
+        if (! cut.isBypassed<0>()) processSection(cut.get<0>());
+        if (! cut.isBypassed<1>()) processSection(cut.get<1>());
+        if (! cut.isBypassed<2>()) processSection(cut.get<2>());
+        if (! cut.isBypassed<3>()) processSection(cut.get<3>());
+    };
+
+    if (! chain.isBypassed<ChainPositions::LowCut>())
+        processCutFilter(chain.get<ChainPositions::LowCut>());
+
+    if (! chain.isBypassed<ChainPositions::Peak>())
+        processSection(chain.get<ChainPositions::Peak>());
+
+    if (! chain.isBypassed<ChainPositions::HighCut>())
+        processCutFilter(chain.get<ChainPositions::HighCut>());
+}
+
+static double maxError(const std::vector<float>& signal, const std::vector<double>& exact)
+{
+    double error = 0;
+    for (size_t i = 0; i < signal.size(); ++i)
+        error = juce::jmax(error, std::abs(static_cast<double>(signal[i]) - exact[i]));
+    return error;
+}
+
+/**
+    The block engine can't be bit-exact, so instead it must not be meaningfully further
+    from the exact response than the float recursion is.
+ */
+static bool isWithinRoundingOfRecursion(const RenderedResponse& response)
+{
+    return maxError(response.impulse, response.exactImpulse) <= 4.0 * maxError(response.referenceImpulse, response.exactImpulse) + 1.0e-6;
+}
+
+/**
+    The state variable filters are designed from tan(pi f / fs) directly rather than from the
+    biquads' rounded coefficients, so they sit about a coefficient rounding away from them.
+ */
+static constexpr double svfTolerance = 1.0e-3;
+
+static float maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float difference = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        difference = juce::jmax(difference, std::abs(a[i] - b[i]));
+    return difference;
+}
+
+static double toComparableDb(double db)
+{
+    return juce::jlimit(comparisonFloorDb, comparisonCeilingDb, db);
+}
+
+//Evaluates the DTFT of the impulse response at log-spaced frequencies
+static std::vector<double> computeMagnitudesDb(const std::vector<float>& impulse, double sampleRate)
+{
+    std::vector<double> magnitudes;
+
+    for (int i = 0; i < numMagnitudePoints; ++i)
+    {
+        auto freq = juce::mapToLog10(static_cast<double>(i) / (numMagnitudePoints - 1), 20.0, 20000.0);
+        auto w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+
+        std::complex<double> sum, rotation(std::cos(-w), std::sin(-w)), phasor(1.0, 0.0);
+        for (auto h : impulse)
+        {
+            sum += static_cast<double>(h) * phasor;
+            phasor *= rotation;
+        }
+        magnitudes.push_back(juce::Decibels::gainToDecibels(std::abs(sum), -200.0));
+    }
+    return magnitudes;
+}
+
+static std::vector<float> makeImpulse()
+{
+    std::vector<float> impulse(impulseLength, 0.f);
+    impulse[0] = 1.f;
+    return impulse;
+}
+
+//Exponential sweep, 20 Hz to 20 kHz in one second
+static std::vector<float> makeSweep(double sampleRate)
+{
+    std::vector<float> sweep(static_cast<size_t>(sampleRate));
+
+    const auto k = std::log(20000.0 / 20.0);
+    for (size_t i = 0; i < sweep.size(); ++i)
+    {
+        auto t = static_cast<double>(i) / sampleRate;
+        auto phase = juce::MathConstants<double>::twoPi * 20.0 * (std::exp(t * k) - 1.0) / k;
+        sweep[i] = static_cast<float>(0.5 * std::sin(phase));
+    }
+    return sweep;
+}
+
+//The RMS level of each segment of the processed sweep
+static std::vector<double> measureSweepDb(float* samples, int length)
+{
+    const juce::AudioBuffer<float> sweep(&samples, 1, length);
+    std::vector<double> levels;
+
+    auto segmentLength = length / numSweepSegments;
+    for (int s = 0; s < numSweepSegments; ++s)
+        levels.push_back(juce::Decibels::gainToDecibels(static_cast<double>(sweep.getRMSLevel(0, s * segmentLength, segmentLength)), -200.0));
+
+    return levels;
+}
+
+/**
+    How far each point of the response moves when the feedback coefficients are nudged a few
+    rounding steps. Steep low cuts at high sample rates and narrow low peaks put their poles
+    so close to the unit circle that a compiler or libm rounding the design differently moves
+    them by that much, so the check allows for it at those points rather than everywhere.
+ */
+static void measureRoundingSlack(const ResponseCase& c, const std::vector<float>& sweep, RenderedResponse& response)
+{
+    response.magnitudeSlackDb.assign(numMagnitudePoints, 0.0);
+    response.sweepSlackDb.assign(numSweepSegments, 0.0);
+
+    auto widen = [](std::vector<double>& slack, const std::vector<double>& nudged, const std::vector<double>& values)
+    {
+        for (size_t i = 0; i < slack.size(); ++i)
+            slack[i] = juce::jmax(slack[i], std::abs(toComparableDb(nudged[i]) - toComparableDb(values[i])));
+    };
+
+    for (auto a1Direction : { -1.f, 1.f })
+        for (auto a2Direction : { -1.f, 1.f })
+        {
+            MonoChain chain;
+            designReferenceChain(chain, c.settings, c.sampleRate);
+            nudgeFeedbackCoefficients(chain, a1Direction, a2Direction);
+
+            auto impulse = makeImpulse();
+            processThroughMonoChain(chain, c.sampleRate, impulse);
+            widen(response.magnitudeSlackDb, computeMagnitudesDb(impulse, c.sampleRate), response.magnitudeDb);
+
+            auto nudgedSweep = sweep;
+            processThroughMonoChain(chain, c.sampleRate, nudgedSweep);
+            widen(response.sweepSlackDb, measureSweepDb(nudgedSweep.data(), static_cast<int>(nudgedSweep.size())), response.sweepDb);
+        }
+}
+
+static RenderedResponse renderResponse(ZooEQAudioProcessor& processor, const ResponseCase& c, bool withSlack)
+{
+    RenderedResponse response;
+
+    // === Impulse === //
+    const auto unitImpulse = makeImpulse();
+    juce::AudioBuffer<float> impulse(2, impulseLength);
+    impulse.copyFrom(0, 0, unitImpulse.data(), impulseLength);
+    impulse.copyFrom(1, 0, unitImpulse.data(), impulseLength);
+
+    processor.prepareToPlay(c.sampleRate, blockSize);
+    processThroughProcessor(processor, impulse);
+
+    response.impulse.assign(impulse.getReadPointer(0), impulse.getReadPointer(0) + impulseLength);
+    response.parallelForm = processor.getFilterTopology() == FilterTopology::parallel && processor.getParallelDesign().valid;
+    response.magnitudeDb = computeMagnitudesDb(response.impulse, c.sampleRate);
+
+    MonoChain reference;
+    designReferenceChain(reference, c.settings, c.sampleRate);
+    response.referenceImpulse = unitImpulse;
+    processThroughMonoChain(reference, c.sampleRate, response.referenceImpulse);
+
+    response.exactImpulse.assign(impulseLength, 0.0);
+    response.exactImpulse[0] = 1.0;
+    processInDouble(c.settings, c.sampleRate, response.exactImpulse);
+
+    // === Sweep === //
+    const auto unitSweep = makeSweep(c.sampleRate);
+    const auto sweepLength = static_cast<int>(unitSweep.size());
+    juce::AudioBuffer<float> sweep(2, sweepLength);
+    sweep.copyFrom(0, 0, unitSweep.data(), sweepLength);
+    sweep.copyFrom(1, 0, unitSweep.data(), sweepLength);
+
+    processor.prepareToPlay(c.sampleRate, blockSize);
+    processThroughProcessor(processor, sweep);
+    response.sweepDb = measureSweepDb(sweep.getWritePointer(0), sweepLength);
+
+    if (withSlack)
+        measureRoundingSlack(c, unitSweep, response);
+
+    return response;
+}
+
+//==============================================================================
+//Rounded to 1e-4 dB, far below any tolerance, so the golden file stays readable
+static juce::var toVar(const std::vector<double>& values)
+{
+    juce::Array<juce::var> array;
+    for (auto v : values)
+        array.add(std::round(v * 1.0e4) / 1.0e4);
+    return array;
+}
+
+static juce::var describeCase(const ResponseCase& c, const RenderedResponse& response)
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("sampleRate", c.sampleRate);
+    obj->setProperty("lowCutFreq", c.settings.lowCutFreq);
+    obj->setProperty("highCutFreq", c.settings.highCutFreq);
+    obj->setProperty("peakFreq", c.settings.peakFreq);
+    obj->setProperty("peakGain", c.settings.peakGainInDecibels);
+    obj->setProperty("peakQuality", c.settings.peakQuality);
+    obj->setProperty("lowCutSlope", static_cast<int>(c.settings.lowCutSlope));
+    obj->setProperty("highCutSlope", static_cast<int>(c.settings.highCutSlope));
+    obj->setProperty("lowCutBypassed", c.settings.lowCutBypassed);
+    obj->setProperty("peakBypassed", c.settings.peakBypassed);
+    obj->setProperty("highCutBypassed", c.settings.highCutBypassed);
+    obj->setProperty("magnitudeDb", toVar(response.magnitudeDb));
+    obj->setProperty("sweepDb", toVar(response.sweepDb));
+    obj->setProperty("magnitudeSlackDb", toVar(response.magnitudeSlackDb));
+    obj->setProperty("sweepSlackDb", toVar(response.sweepSlackDb));
+    return juce::var(obj);
+}
+
+//The case describeCase() wrote, so the check doesn't depend on regenerating the same grid
+static ResponseCase readCase(const juce::var& golden)
+{
+    ResponseCase c;
+    c.sampleRate = golden.getProperty("sampleRate", 0.0);
+    c.settings.lowCutFreq = golden.getProperty("lowCutFreq", 0.f);
+    c.settings.highCutFreq = golden.getProperty("highCutFreq", 0.f);
+    c.settings.peakFreq = golden.getProperty("peakFreq", 0.f);
+    c.settings.peakGainInDecibels = golden.getProperty("peakGain", 0.f);
+    c.settings.peakQuality = golden.getProperty("peakQuality", 0.f);
+    c.settings.lowCutSlope = static_cast<Slope>(static_cast<int>(golden.getProperty("lowCutSlope", 0)));
+    c.settings.highCutSlope = static_cast<Slope>(static_cast<int>(golden.getProperty("highCutSlope", 0)));
+    c.settings.lowCutBypassed = golden.getProperty("lowCutBypassed", false);
+    c.settings.peakBypassed = golden.getProperty("peakBypassed", false);
+    c.settings.highCutBypassed = golden.getProperty("highCutBypassed", false);
+
+    if (c.sampleRate <= 0)
+        juce::ConsoleApplication::fail("A golden case has no sample rate");
+
+    return c;
+}
+
+/** How much further than its slack any value is from the golden one, the slack being 0 where there is none */
+static double maxDeviation(const std::vector<double>& values, const juce::var& golden, const juce::var& slack)
+{
+    auto* goldenValues = golden.getArray();
+    if (goldenValues == nullptr || goldenValues->size() != static_cast<int>(values.size()))
+        return std::numeric_limits<double>::infinity();
+
+    auto* slackValues = slack.getArray();
+    if (slackValues != nullptr && slackValues->size() != static_cast<int>(values.size()))
+        return std::numeric_limits<double>::infinity();
+
+    double deviation = 0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        auto value = toComparableDb(values[i]);
+        auto goldenValue = toComparableDb((*goldenValues)[static_cast<int>(i)]);
+        auto allowed = slackValues != nullptr ? static_cast<double>((*slackValues)[static_cast<int>(i)]) : 0.0;
+        deviation = juce::jmax(deviation, std::abs(value - goldenValue) - allowed);
+    }
+    return deviation;
+}
+
+bool isResponseCheckRequested(const juce::ArgumentList& args)
+{
+    return args.containsOption("--write-responses|--check-responses|--bit-exact");
+}
+
+FilterEngine getFilterEngine(const juce::ArgumentList& args)
+{
+    if (! args.containsOption("--engine"))
+        return FilterEngine::recursive;
+
+    auto engine = args.getValueForOption("--engine");
+    if (engine == "block")
+        return FilterEngine::blockStateSpace;
+    if (engine == "svf")
+        return FilterEngine::stateVariable;
+    if (engine != "recursive")
+        juce::ConsoleApplication::fail("Unknown engine: " + engine);
+
+    return FilterEngine::recursive;
+}
+
+FilterTopology getFilterTopology(const juce::ArgumentList& args)
+{
+    if (! args.containsOption("--topology"))
+        return FilterTopology::series;
+
+    auto topology = args.getValueForOption("--topology");
+    if (topology == "parallel")
+        return FilterTopology::parallel;
+    if (topology != "series")
+        juce::ConsoleApplication::fail("Unknown topology: " + topology);
+
+    return FilterTopology::series;
+}
+
+std::optional<InstructionSet> getForcedInstructionSet(const juce::ArgumentList& args)
+{
+    if (! args.containsOption("--kernels"))
+        return std::nullopt;
+
+    auto name = args.getValueForOption("--kernels");
+    InstructionSet instructionSet {};
+
+    if (! parseInstructionSet(name.toRawUTF8(), instructionSet))
+        juce::ConsoleApplication::fail("Unknown kernels: " + name);
+
+    if (getDspKernels(instructionSet) == nullptr)
+        juce::ConsoleApplication::fail("The " + name + " kernels aren't available in this build or on this CPU");
+
+    return instructionSet;
+}
+
+int runResponseChecks(const juce::ArgumentList& args)
+{
+    auto tolerance = defaultToleranceDb;
+    if (args.containsOption("--tolerance"))
+        tolerance = args.getValueForOption("--tolerance").getDoubleValue();
+
+    juce::var golden;
+    if (args.containsOption("--check-responses"))
+    {
+        golden = juce::JSON::parse(args.getExistingFileForOption("--check-responses"));
+        if (golden.getProperty("cases", {}).getArray() == nullptr)
+            juce::ConsoleApplication::fail("Not a response file: " + args.getValueForOption("--check-responses"));
+    }
+
+    const auto checkBitExact = args.containsOption("--bit-exact");
+    const auto writeResponses = args.containsOption("--write-responses");
+    auto* goldenCases = golden.getProperty("cases", {}).getArray();
+
+    std::vector<ResponseCase> cases;
+    if (goldenCases != nullptr)
+        for (const auto& goldenCase : *goldenCases)
+            cases.push_back(readCase(goldenCase));
+    else
+        cases = makeResponseCases();
+
+    ZooEQAudioProcessor processor;
+    processor.forceInstructionSet(getForcedInstructionSet(args));
+
+    const auto engine = getFilterEngine(args);
+    processor.setFilterEngine(false, engine);
+    processor.setFilterEngine(true, engine);
+    processor.setFilterTopology(getFilterTopology(args));
+
+    //Rendering offline makes the processor design the parallel form before the first block,
+    //rather than on its designer thread some time later
+    processor.setNonRealtime(true);
+
+    juce::Array<juce::var> written;
+
+    int numDeviating = 0, numNotBitExact = 0, numParallel = 0;
+    double worstDeviation = 0;
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        auto c = cases[i];
+
+        processor.setPlayConfigDetails(2, 2, c.sampleRate, blockSize);
+        applyChainSettings(processor.apvts, c.settings);
+
+        //What the parameters actually hold, after snapping to their intervals
+        c.settings = getChainSettings(processor.apvts);
+
+        auto response = renderResponse(processor, c, writeResponses);
+
+        if (writeResponses)
+            written.add(describeCase(c, response));
+
+        if (goldenCases != nullptr)
+        {
+            auto goldenCase = (*goldenCases)[static_cast<int>(i)];
+            auto deviation = juce::jmax(maxDeviation(response.magnitudeDb, goldenCase.getProperty("magnitudeDb", {}),
+                                                     goldenCase.getProperty("magnitudeSlackDb", {})),
+                                        maxDeviation(response.sweepDb, goldenCase.getProperty("sweepDb", {}),
+                                                     goldenCase.getProperty("sweepSlackDb", {})));
+            worstDeviation = juce::jmax(worstDeviation, deviation);
+
+            if (deviation > tolerance)
+            {
+                ++numDeviating;
+                std::cout << "Case " << i << " deviates from the golden response by " << deviation << " dB beyond its rounding slack" << std::endl;
+            }
+        }
+
+        if (response.parallelForm)
+        {
+            ++numParallel;
+
+            //The expansion rounds differently from the cascade, so it can only be as close as the designer
+            //demands, with some slack for the SIMD kernels summing the sections in another order
+            if (checkBitExact && maxDifference(response.impulse, response.referenceImpulse) > 2.0f * ParallelDesign::maxImpulseError)
+            {
+                ++numNotBitExact;
+                std::cout << "Case " << i << ": the parallel form is off by " << maxDifference(response.impulse, response.referenceImpulse)
+                          << " from the cascade" << std::endl;
+            }
+        }
+        else if (checkBitExact && engine == FilterEngine::recursive && response.impulse != response.referenceImpulse)
+        {
+            ++numNotBitExact;
+            std::cout << "Case " << i << ": processBlock() is not bit-exact with MonoChain" << std::endl;
+        }
+
+        else if (checkBitExact && engine == FilterEngine::blockStateSpace && ! isWithinRoundingOfRecursion(response))
+        {
+            ++numNotBitExact;
+            std::cout << "Case " << i << ": the block engine is off by " << maxError(response.impulse, response.exactImpulse)
+                      << ", the recursion by " << maxError(response.referenceImpulse, response.exactImpulse) << std::endl;
+        }
+        else if (checkBitExact && engine == FilterEngine::stateVariable && maxError(response.impulse, response.exactImpulse) > svfTolerance)
+        {
+            ++numNotBitExact;
+            std::cout << "Case " << i << ": the state variable filters are off by " << maxError(response.impulse, response.exactImpulse)
+                      << std::endl;
+        }
+    }
+
+    if (writeResponses)
+    {
+        //One case per line, so a diff of the golden file shows which cases moved
+        juce::String text("{\"version\": 1, \"cases\": [\n");
+        for (int i = 0; i < written.size(); ++i)
+            text << juce::JSON::toString(written[i], true) << (i + 1 < written.size() ? ",\n" : "\n");
+        text << "]}\n";
+
+        auto file = args.getFileForOption("--write-responses");
+        if (! file.replaceWithText(text))
+            juce::ConsoleApplication::fail("Cannot write " + file.getFullPathName());
+    }
+
+    std::cout << cases.size() << " cases in " << juce::String((juce::Time::getMillisecondCounterHiRes() - start) / 1000.0, 2) << " s";
+    if (golden.isObject())
+        std::cout << ", " << numDeviating << " outside " << tolerance << " dB (worst " << worstDeviation << " dB)";
+    if (checkBitExact)
+        std::cout << ", " << numNotBitExact << " not bit-exact";
+    if (processor.getFilterTopology() == FilterTopology::parallel)
+        std::cout << ", " << numParallel << " in parallel form (the rest fell back to the cascade)";
+    std::cout << std::endl;
+
+    return numDeviating == 0 && numNotBitExact == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    Frequency-response regression checks for the DSP core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <optional>
+#include "dsp/FilterChain.h"
+#include "dsp/ParallelSections.h"
+
+/**
+    Renders impulses and sweeps through the processor and a raw pair of
+    MonoChains for a fixed grid of ChainSettings, or for the cases of the
+    golden file. Depending on the options it writes the responses as golden
+    JSON (--write-responses), compares them to a golden file
+    (--check-responses) and/or checks that processBlock() is bit-exact with
+    the reference MonoChain (--bit-exact).
+
+    Golden files hold each point's rounding slack as well, how far it moves
+    when the coefficients round differently. Points only fail once they are
+    further than the tolerance beyond it.
+
+    Returns the process exit code.
+ */
+int runResponseChecks(const juce::ArgumentList& args);
+
+bool isResponseCheckRequested(const juce::ArgumentList& args);
+
+/** Reads --kernels <scalar|sse2|avx2|avx512|neon>, failing if this build or CPU can't run it */
+std::optional<InstructionSet> getForcedInstructionSet(const juce::ArgumentList& args);
+
+/** Reads --engine <recursive|block|svf> */
+FilterEngine getFilterEngine(const juce::ArgumentList& args);
+
+/** Reads --topology <series|parallel> */
+FilterTopology getFilterTopology(const juce::ArgumentList& args);
@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+    Session recall benchmark for the plugin state.
+
+    Saves and restores the state of many processor instances, like a host
+    recalling a large session, in the binary format and in the ValueTree
+    format the plugin used to save, and reports the cost per instance.
+    Then switches programs at random in a large preset bank.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "StateFormat.h"
+#include "PresetBank.h"
+
+static void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float value)
+{
+    auto* param = apvts.getParameter(id);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+//What getStateInformation() wrote before the binary format
+static juce::MemoryBlock makeValueTreeState(juce::AudioProcessorValueTreeState& apvts)
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream mos(block, true);
+    apvts.copyState().writeToStream(mos);
+    return block;
+}
+
+struct Timing
+{
+    double saveMicroseconds = 0, loadMicroseconds = 0;
+    size_t bytes = 0;
+};
+
+/**
+    Alternates every instance between two different states, so each load really
+    changes all the parameters rather than hitting the unchanged shortcut.
+ */
+template<typename SaveFunction>
+static Timing measure(std::vector<std::unique_ptr<ZooEQAudioProcessor>>& instances,
+                      const std::array<juce::MemoryBlock, 2>& states,
+                      int rounds,
+                      SaveFunction save)
+{
+    Timing timing;
+    timing.bytes = states[0].getSize();
+    
+    auto start = juce::Time::getHighResolutionTicks();
+    
+    for (int round = 0; round < rounds; ++round)
+        for (auto& instance : instances)
+        {
+            auto& state = states[static_cast<size_t>(round % 2)];
+            instance->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        }
+    
+    auto loaded = juce::Time::getHighResolutionTicks();
+    
+    for (int round = 0; round < rounds; ++round)
+        for (auto& instance : instances)
+            save(*instance);
+    
+    auto saved = juce::Time::getHighResolutionTicks();
+    
+    const auto numLoads = static_cast<double>(rounds) * static_cast<double>(instances.size());
+    timing.loadMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(loaded - start) / numLoads;
+    timing.saveMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(saved - loaded) / numLoads;
+    return timing;
+}
+
+struct ProgramTiming
+{
+    double switchMicroseconds = 0, nameMicroseconds = 0;
+};
+
+/** Builds a bank of numPresets variations of state, and jumps around it like a preset browser */
+static ProgramTiming measureProgramSwitching(ZooEQAudioProcessor& processor, const juce::MemoryBlock& state, int numPresets)
+{
+    std::vector<PresetBank::Preset> presets;
+    juce::Random random(0x62616e6b);
+    
+    for (int i = 0; i < numPresets; ++i)
+    {
+        ZooEQAudioProcessor variation;
+        variation.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        setParameter(variation.apvts, "Peak Freq", 20.f + 19980.f * random.nextFloat());
+        setParameter(variation.apvts, "Peak Gain", -24.f + 48.f * random.nextFloat());
+        
+        PresetBank::Preset preset { "Preset " + juce::String(i), {} };
+        variation.getStateInformation(preset.state);
+        presets.push_back(std::move(preset));
+    }
+    
+    juce::TemporaryFile bankFile(".myeqbank");
+    if (! PresetBank::write(bankFile.getFile(), presets) || ! processor.loadPresetBank(bankFile.getFile()))
+        juce::ConsoleApplication::fail("Cannot write a preset bank to " + bankFile.getFile().getFullPathName());
+    
+    std::vector<int> order;
+    for (int i = 0; i < 100000; ++i)
+        order.push_back(random.nextInt(processor.getNumPrograms()));
+    
+    ProgramTiming timing;
+    
+    auto start = juce::Time::getHighResolutionTicks();
+    for (auto index : order)
+        processor.setCurrentProgram(index);
+    
+    auto switched = juce::Time::getHighResolutionTicks();
+    for (auto index : order)
+        processor.getProgramName(index);
+    
+    auto named = juce::Time::getHighResolutionTicks();
+    
+    timing.switchMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(switched - start) / static_cast<double>(order.size());
+    timing.nameMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(named - switched) / static_cast<double>(order.size());
+    return timing;
+}
+
+static juce::var toVar(const juce::String& format, const Timing& timing)
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("format", format);
+    obj->setProperty("bytes", static_cast<int>(timing.bytes));
+    obj->setProperty("loadMicroseconds", timing.loadMicroseconds);
+    obj->setProperty("saveMicroseconds", timing.saveMicroseconds);
+    return juce::var(obj);
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: myEQStateBenchmarks [options]" << std::endl
+              << std::endl
+              << "  --json <file>       Write the results as JSON" << std::endl
+              << "  --instances <n>     Processor instances in the session (default: 256)" << std::endl
+              << "  --rounds <n>        Loads per instance (default: 20)" << std::endl
+              << "  --presets <n>       Presets in the bank for program switching (default: 5000)" << std::endl
+              << "  --cpu <n>           Core to pin the benchmark thread to (default: 0)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        auto numInstances = 256;
+        if (args.containsOption("--instances"))
+            numInstances = juce::jmax(1, args.getValueForOption("--instances").getIntValue());
+
+        auto rounds = 20;
+        if (args.containsOption("--rounds"))
+            rounds = juce::jmax(2, args.getValueForOption("--rounds").getIntValue());
+
+        auto numPresets = 5000;
+        if (args.containsOption("--presets"))
+            numPresets = juce::jmax(1, args.getValueForOption("--presets").getIntValue());
+
+        auto cpu = 0;
+        if (args.containsOption("--cpu"))
+        {
+            cpu = args.getValueForOption("--cpu").getIntValue();
+
+            //The affinity mask is 32 bits wide
+            if (cpu < 0 || cpu > 31)
+                juce::ConsoleApplication::fail("--cpu must be between 0 and 31");
+        }
+
+        juce::Thread::setCurrentThreadAffinityMask(static_cast<juce::uint32>(1) << cpu);
+
+        //Two sets of settings that differ in every parameter
+        ZooEQAudioProcessor source;
+        std::array<juce::MemoryBlock, 2> binaryStates, valueTreeStates;
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            auto flip = i == 1;
+            setParameter(source.apvts, "LowCut Freq", flip ? 120.f : 35.f);
+            setParameter(source.apvts, "HighCut Freq", flip ? 9000.f : 16000.f);
+            setParameter(source.apvts, "Peak Freq", flip ? 2500.f : 400.f);
+            setParameter(source.apvts, "Peak Gain", flip ? -6.f : 4.5f);
+            setParameter(source.apvts, "Peak Quality", flip ? 3.f : 0.6f);
+            setParameter(source.apvts, "LowCut Slope", flip ? 3.f : 1.f);
+            setParameter(source.apvts, "HighCut Slope", flip ? 2.f : 0.f);
+            setParameter(source.apvts, "LowCut Bypassed", flip ? 1.f : 0.f);
+            setParameter(source.apvts, "Peak Bypassed", flip ? 0.f : 1.f);
+            setParameter(source.apvts, "HighCut Bypassed", flip ? 1.f : 0.f);
+            setParameter(source.apvts, "Analyser Enable", flip ? 0.f : 1.f);
+
+            source.getStateInformation(binaryStates[i]);
+            valueTreeStates[i] = makeValueTreeState(source.apvts);
+        }
+
+        if (! isBinaryState(binaryStates[0].getData(), binaryStates[0].getSize()))
+            juce::ConsoleApplication::fail("getStateInformation() didn't write the binary format");
+
+        std::vector<std::unique_ptr<ZooEQAudioProcessor>> instances;
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back(std::make_unique<ZooEQAudioProcessor>());
+
+        auto binary = measure(instances, binaryStates, rounds, [](ZooEQAudioProcessor& processor)
+        {
+            juce::MemoryBlock block;
+            processor.getStateInformation(block);
+        });
+
+        auto valueTree = measure(instances, valueTreeStates, rounds, [](ZooEQAudioProcessor& processor)
+        {
+            makeValueTreeState(processor.apvts);
+        });
+
+        auto print = [](const juce::String& name, const Timing& timing)
+        {
+            std::cout << name.paddedRight(' ', 12)
+                      << juce::String(static_cast<int>(timing.bytes)).paddedRight(' ', 8)
+                      << juce::String(timing.loadMicroseconds, 2).paddedRight(' ', 12)
+                      << juce::String(timing.saveMicroseconds, 2) << std::endl;
+        };
+
+        std::cout << numInstances << " instances, " << rounds << " loads each" << std::endl
+                  << "format      bytes   load (us)   save (us)" << std::endl;
+        print("binary", binary);
+        print("valuetree", valueTree);
+
+        std::cout << "Recalling the session takes " << juce::String(binary.loadMicroseconds * numInstances / 1000.0, 2)
+                  << " ms instead of " << juce::String(valueTree.loadMicroseconds * numInstances / 1000.0, 2) << " ms" << std::endl;
+
+        auto programs = measureProgramSwitching(*instances.front(), binaryStates[0], numPresets);
+
+        std::cout << "Switching between " << numPresets << " programs takes " << juce::String(programs.switchMicroseconds, 2)
+                  << " us, getProgramName() " << juce::String(programs.nameMicroseconds, 2) << " us" << std::endl;
+
+        if (args.containsOption("--json"))
+        {
+            auto* root = new juce::DynamicObject();
+            root->setProperty("cpuModel", juce::SystemStats::getCpuModel());
+            root->setProperty("instances", numInstances);
+            root->setProperty("rounds", rounds);
+            root->setProperty("results", juce::Array<juce::var> { toVar("binary", binary), toVar("valuetree", valueTree) });
+            root->setProperty("presets", numPresets);
+            root->setProperty("programSwitchMicroseconds", programs.switchMicroseconds);
+            root->setProperty("programNameMicroseconds", programs.nameMicroseconds);
+
+            auto file = args.getFileForOption("--json");
+            if (! file.replaceWithText(juce::JSON::toString(juce::var(root))))
+                juce::ConsoleApplication::fail("Cannot write " + file.getFullPathName());
+        }
+
+        return 0;
+    });
+}
@@ -7,13 +7,14 @@ def run(cmd, cwd=None):
     print(f"> {' '.join(cmd)}")
     subprocess.check_call(cmd, cwd=cwd)
 
-def main(build_dir, build_type, generator=None, parallel=None):
+def main(build_dir, build_type, generator=None, parallel=None, options=()):
     root = os.path.abspath(os.path.dirname(__file__))
 
     # 1. Configure
     cfg_cmd = ["cmake", "-B", build_dir, "-DCMAKE_BUILD_TYPE=" + build_type]
     if generator:
         cfg_cmd += ["-G", generator]
+    cfg_cmd += ["-D" + option for option in options]
     cfg_cmd.append(root)
     run(cfg_cmd)
 
@@ -30,5 +31,20 @@ if __name__ == "__main__":
     p.add_argument("--config", "-c", default="Release", choices=["Debug","Release","RelWithDebInfo"], help="Build configuration")
     p.add_argument("--generator", "-G", help="CMake generator (e.g. Ninja, Xcode, \"Visual Studio 17 2022\")")
     p.add_argument("--parallel", "-j", type=int, help="Parallel build jobs")
+    p.add_argument("--renderer", action="store_true", help="Also build the myEQRender offline renderer")
+    p.add_argument("--benchmarks", action="store_true", help="Also build the myEQBenchmarks performance suite")
+    p.add_argument("--no-tests", action="store_true", help="Don't build the tests")
+    p.add_argument("--dsp-arch-flags", help="Extra compile flags for the DSP core library (e.g. \"-march=x86-64-v3\")")
     args = p.parse_args()
-    main(args.build_dir, args.config, args.generator, args.parallel)
+
+    options = []
+    if args.renderer:
+        options.append("MYEQ_BUILD_RENDERER=ON")
+    if args.benchmarks:
+        options.append("MYEQ_BUILD_BENCHMARKS=ON")
+    if args.no_tests:
+        options.append("MYEQ_BUILD_TESTS=OFF")
+    if args.dsp_arch_flags:
+        options.append("MYEQ_DSP_ARCH_FLAGS=" + args.dsp_arch_flags)
+
+    main(args.build_dir, args.config, args.generator, args.parallel, options)
@@ -0,0 +1,457 @@
+/*
+  ==============================================================================
+
+    Offline renderer: runs the EQ headless over a batch of audio files.
+
+    Files are sharded across a pool of worker threads. Every worker owns its
+    own ZooEQAudioProcessor, pops jobs from its own queue and steals from the
+    others once it runs dry. Disk reads and writes are overlapped with the
+    processing through JUCE's buffering reader / threaded writer.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <deque>
+#include <map>
+
+struct RenderJob
+{
+    juce::File input, output;
+};
+
+struct RenderStats
+{
+    double audioSeconds = 0;
+    int filesRendered = 0, filesFailed = 0;
+};
+
+//==============================================================================
+/**
+    Per-worker job queue. The owner pops from the front, idle workers steal from the back.
+ */
+struct JobQueue
+{
+    void push(int job)
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        jobs.push_back(job);
+    }
+
+    bool pop(int& job)
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        if (jobs.empty())
+            return false;
+
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+
+    bool steal(int& job)
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        if (jobs.empty())
+            return false;
+
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+
+private:
+    juce::SpinLock lock;
+    std::deque<int> jobs;
+};
+
+struct RenderContext
+{
+    std::vector<RenderJob> jobs;
+    std::vector<std::unique_ptr<JobQueue>> queues;
+
+    juce::MemoryBlock presetState;
+    int blockSize = 512;
+    int bitsPerSample = 24;
+    FilterEngine engine = FilterEngine::recursive;
+    FilterTopology topology = FilterTopology::series;
+
+    //Reads and writes get their own disk thread so that both directions overlap
+    juce::TimeSliceThread readThread { "myEQ disk read" };
+    juce::TimeSliceThread writeThread { "myEQ disk write" };
+
+    juce::CriticalSection logLock;
+
+    void log(const juce::String& message)
+    {
+        const juce::ScopedLock sl(logLock);
+        std::cout << message << std::endl;
+    }
+};
+
+//==============================================================================
+class RenderWorker : public juce::Thread
+{
+public:
+    RenderWorker(RenderContext& c, int workerIndex) :
+    juce::Thread("myEQ render worker " + juce::String(workerIndex)),
+    context(c),
+    index(workerIndex)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~RenderWorker() override
+    {
+        stopThread(-1);
+    }
+
+    void run() override
+    {
+        int job = 0;
+        while (! threadShouldExit() && nextJob(job))
+        {
+            auto ok = render(context.jobs[static_cast<size_t>(job)]);
+
+            if (ok)
+                ++stats.filesRendered;
+            else
+                ++stats.filesFailed;
+        }
+    }
+
+    const RenderStats& getStats() const { return stats; }
+
+private:
+    RenderContext& context;
+    int index;
+
+    juce::AudioFormatManager formatManager;
+
+    //One processor per stereo pair of the widest file seen so far
+    std::vector<std::unique_ptr<ZooEQAudioProcessor>> processors;
+
+    juce::AudioBuffer<float> fileBuffer, pairBuffer;
+    juce::MidiBuffer midi;
+
+    RenderStats stats;
+
+    bool nextJob(int& job)
+    {
+        if (context.queues[static_cast<size_t>(index)]->pop(job))
+            return true;
+
+        auto numQueues = static_cast<int>(context.queues.size());
+        for (int i = 1; i < numQueues; ++i)
+        {
+            auto victim = (index + i) % numQueues;
+            if (context.queues[static_cast<size_t>(victim)]->steal(job))
+                return true;
+        }
+        return false;
+    }
+
+    void prepareProcessors(int numPairs, double sampleRate)
+    {
+        auto numExisting = static_cast<int>(processors.size());
+
+        while (static_cast<int>(processors.size()) < numPairs)
+        {
+            auto processor = std::make_unique<ZooEQAudioProcessor>();
+            processor->setNonRealtime(true);
+            processor->setFilterEngine(true, context.engine);
+            processor->setFilterTopology(context.topology);
+            processors.push_back(std::move(processor));
+        }
+
+        //Re-preparing also resets the filter states so that files don't bleed into each other
+        for (int pair = 0; pair < numPairs; ++pair)
+        {
+            auto& processor = *processors[static_cast<size_t>(pair)];
+            processor.setPlayConfigDetails(2, 2, sampleRate, context.blockSize);
+
+            //The state is applied once the processor knows its sample rate
+            if (pair >= numExisting && context.presetState.getSize() > 0)
+                processor.setStateInformation(context.presetState.getData(),
+                                              static_cast<int>(context.presetState.getSize()));
+
+            processor.prepareToPlay(sampleRate, context.blockSize);
+        }
+    }
+
+    bool render(const RenderJob& job)
+    {
+        auto* rawReader = formatManager.createReaderFor(job.input);
+        if (rawReader == nullptr)
+        {
+            context.log("Cannot read " + job.input.getFullPathName());
+            return false;
+        }
+
+        const auto sampleRate = rawReader->sampleRate;
+        const auto numChannels = static_cast<int>(rawReader->numChannels);
+        const auto length = rawReader->lengthInSamples;
+
+        //The reader reads ahead on the disk thread while we are processing
+        juce::BufferingAudioReader reader(rawReader, context.readThread, 8 * context.blockSize);
+        reader.setReadTimeout(-1);
+
+        job.output.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream(job.output.createOutputStream());
+        if (stream == nullptr)
+        {
+            context.log("Cannot write " + job.output.getFullPathName());
+            return false;
+        }
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(),
+                                                                            sampleRate,
+                                                                            static_cast<unsigned int>(numChannels),
+                                                                            context.bitsPerSample,
+                                                                            {},
+                                                                            0));
+        if (writer == nullptr)
+        {
+            context.log("Cannot create a writer for " + job.output.getFullPathName());
+            return false;
+        }
+        stream.release(); //now owned by the writer
+
+        //...and the writer flushes on the other disk thread
+        juce::AudioFormatWriter::ThreadedWriter threadedWriter(writer.release(),
+                                                               context.writeThread,
+                                                               8 * context.blockSize);
+
+        const auto numPairs = (numChannels + 1) / 2;
+        prepareProcessors(numPairs, sampleRate);
+
+        fileBuffer.setSize(numChannels, context.blockSize, false, false, true);
+
+        //Every pair plays the same preset, so they all delay by the same amount. The first that
+        //many samples out are dropped, and as many zeros flushed through at the end for the tail.
+        const auto latency = processors.front()->getLatencySamples();
+        const auto processedLength = length + latency;
+        auto numToDrop = static_cast<juce::int64>(latency);
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < processedLength; position += context.blockSize)
+        {
+            auto numSamples = static_cast<int>(juce::jmin<juce::int64>(context.blockSize, processedLength - position));
+            auto numFromFile = static_cast<int>(juce::jlimit<juce::int64>(0, numSamples, length - position));
+
+            if (numFromFile > 0)
+                reader.read(&fileBuffer, 0, numFromFile, position, true, true);
+
+            fileBuffer.clear(numFromFile, numSamples - numFromFile);
+
+            for (int pair = 0; pair < numPairs; ++pair)
+            {
+                //A mono file (or the odd channel out) is fed to both sides of the processor
+                auto first = pair * 2;
+                auto second = juce::jmin(first + 1, numChannels - 1);
+
+                pairBuffer.setSize(2, numSamples, false, false, true);
+                pairBuffer.copyFrom(0, 0, fileBuffer, first, 0, numSamples);
+                pairBuffer.copyFrom(1, 0, fileBuffer, second, 0, numSamples);
+
+                processors[static_cast<size_t>(pair)]->processBlock(pairBuffer, midi);
+
+                fileBuffer.copyFrom(first, 0, pairBuffer, 0, 0, numSamples);
+                if (second != first)
+                    fileBuffer.copyFrom(second, 0, pairBuffer, 1, 0, numSamples);
+            }
+
+            auto numDropped = static_cast<int>(juce::jmin<juce::int64>(numToDrop, numSamples));
+            numToDrop -= numDropped;
+
+            if (numDropped == numSamples)
+                continue;
+
+            const juce::AudioBuffer<float> output(fileBuffer.getArrayOfWritePointers(), numChannels,
+                                                  numDropped, numSamples - numDropped);
+
+            while (! threadedWriter.write(output.getArrayOfReadPointers(), output.getNumSamples()))
+                juce::Thread::sleep(1);
+        }
+
+        auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        auto audioSeconds = static_cast<double>(length) / sampleRate;
+        stats.audioSeconds += audioSeconds;
+
+        context.log(job.input.getFileName() + ": " + juce::String(audioSeconds, 1) + " s, "
+                    + juce::String(audioSeconds / juce::jmax(elapsedSeconds, 1.0e-9), 1) + "x real time");
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderWorker)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: myEQRender --output <dir> [options] <files or directories...>" << std::endl
+              << std::endl
+              << "  --output <dir>      Where the rendered .wav files are written" << std::endl
+              << "  --preset <file>     Plugin state to apply (as saved by the host)" << std::endl
+              << "  --threads <n>       Number of render workers (default: number of cores)" << std::endl
+              << "  --block-size <n>    Samples per processBlock call (default: 512)" << std::endl
+              << "  --bits <n>          Output bit depth (default: 24)" << std::endl
+              << "  --engine <e>        Filter engine: recursive, block or svf (default: recursive)" << std::endl
+              << "  --topology <t>      Filter topology: series or parallel (default: series)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h") || ! args.containsOption("--output"))
+    {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        RenderContext context;
+
+        auto outputDir = args.getFileForOption("--output");
+        if (! outputDir.createDirectory())
+            juce::ConsoleApplication::fail("Cannot create " + outputDir.getFullPathName());
+
+        if (args.containsOption("--block-size"))
+            context.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+
+        if (args.containsOption("--bits"))
+            context.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+
+        if (args.containsOption("--engine"))
+        {
+            auto engine = args.getValueForOption("--engine");
+            if (engine == "block")
+                context.engine = FilterEngine::blockStateSpace;
+            else if (engine == "svf")
+                context.engine = FilterEngine::stateVariable;
+            else if (engine != "recursive")
+                juce::ConsoleApplication::fail("Unknown engine: " + engine);
+        }
+
+        if (args.containsOption("--topology"))
+        {
+            auto topology = args.getValueForOption("--topology");
+            if (topology == "parallel")
+                context.topology = FilterTopology::parallel;
+            else if (topology != "series")
+                juce::ConsoleApplication::fail("Unknown topology: " + topology);
+        }
+
+        if (args.containsOption("--preset"))
+            args.getExistingFileForOption("--preset").loadFileAsData(context.presetState);
+
+        auto numThreads = juce::SystemStats::getNumCpus();
+        if (args.containsOption("--threads"))
+            numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+        //Everything that isn't an option (or an option's value) is an input file, or a directory of them
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        const juce::StringArray optionsWithValues { "--output", "--preset", "--threads", "--block-size", "--bits", "--engine", "--topology" };
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+
+            if (arg.isOption())
+            {
+                if (! arg.text.containsChar('=') && optionsWithValues.contains(arg.text))
+                    ++i;
+                continue;
+            }
+
+            auto file = arg.resolveAsFile();
+            juce::Array<juce::File> inputs;
+
+            if (file.isDirectory())
+                inputs = file.findChildFiles(juce::File::findFiles, true, formatManager.getWildcardForAllFormats());
+            else if (file.existsAsFile())
+                inputs.add(file);
+            else
+                juce::ConsoleApplication::fail("No such file: " + file.getFullPathName());
+
+            //A directory's files keep their place in its tree, so same-named files in different subdirectories don't collide
+            for (auto& input : inputs)
+            {
+                auto relativePath = file.isDirectory() ? input.getRelativePathFrom(file) : input.getFileName();
+                auto output = outputDir.getChildFile(relativePath).withFileExtension(".wav");
+                context.jobs.push_back({ input, output });
+            }
+        }
+
+        if (context.jobs.empty())
+            juce::ConsoleApplication::fail("Nothing to render");
+
+        //Two workers writing the same file would interleave or overwrite each other, so that is refused up front
+        std::map<juce::String, juce::File> inputForOutput;
+
+        for (auto& job : context.jobs)
+        {
+            auto [existing, inserted] = inputForOutput.emplace(job.output.getFullPathName(), job.input);
+            if (! inserted)
+                juce::ConsoleApplication::fail(existing->second.getFullPathName() + " and " + job.input.getFullPathName()
+                                               + " would both be rendered to " + job.output.getFullPathName());
+
+            if (! job.output.getParentDirectory().createDirectory())
+                juce::ConsoleApplication::fail("Cannot create " + job.output.getParentDirectory().getFullPathName());
+        }
+
+        numThreads = juce::jmin(numThreads, static_cast<int>(context.jobs.size()));
+
+        //Deal the jobs round-robin; stealing evens out whatever imbalance is left
+        for (int i = 0; i < numThreads; ++i)
+            context.queues.push_back(std::make_unique<JobQueue>());
+
+        for (size_t job = 0; job < context.jobs.size(); ++job)
+            context.queues[job % static_cast<size_t>(numThreads)]->push(static_cast<int>(job));
+
+        context.readThread.startThread();
+        context.writeThread.startThread();
+
+        std::vector<std::unique_ptr<RenderWorker>> workers;
+        for (int i = 0; i < numThreads; ++i)
+            workers.push_back(std::make_unique<RenderWorker>(context, i));
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (auto& worker : workers)
+            worker->startThread();
+
+        RenderStats total;
+        for (auto& worker : workers)
+        {
+            worker->waitForThreadToExit(-1);
+
+            total.audioSeconds += worker->getStats().audioSeconds;
+            total.filesRendered += worker->getStats().filesRendered;
+            total.filesFailed += worker->getStats().filesFailed;
+        }
+
+        //Every file's writer has been flushed by the worker that rendered it
+        auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        context.readThread.stopThread(-1);
+        context.writeThread.stopThread(-1);
+
+        std::cout << "Rendered " << total.filesRendered << " files (" << total.filesFailed << " failed), "
+                  << juce::String(total.audioSeconds, 1) << " s of audio in "
+                  << juce::String(wallSeconds, 2) << " s on " << numThreads << " threads: "
+                  << juce::String(total.audioSeconds / juce::jmax(wallSeconds, 1.0e-9), 1) << "x real time"
+                  << std::endl;
+
+        return total.filesFailed == 0 ? 0 : 1;
+    });
+}
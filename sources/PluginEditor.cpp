@@ -279,6 +279,97 @@ juce::String RotarySliderWithLabels::getDisplayString() const
     }
     return str;
 }
+//==============================================================================
+void StereoAnalyser::addSamples(const float* left, const float* right, int numSamples, double sampleRate)
+{
+    //One decay per buffer rather than per sample, the buffers are short next to correlationTime
+    auto decay = std::exp(-numSamples / (correlationTime * sampleRate));
+    double lr = 0, ll = 0, rr = 0;
+    
+    const auto centre = imageSize * 0.5f;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto l = left[i];
+        auto r = right[i];
+        lr += l * r;
+        ll += l * l;
+        rr += r * r;
+        
+        //Mid upwards and side across, so a mono signal is a vertical line
+        auto x = static_cast<int>(centre + (l - r) * 0.5f * centre);
+        auto y = static_cast<int>(centre - (l + r) * 0.5f * centre);
+        if (x >= 0 && x < imageSize && y >= 0 && y < imageSize)
+            intensity[static_cast<size_t>(y * imageSize + x)] += 1.f;
+    }
+    
+    sumLR = sumLR * decay + lr;
+    sumLL = sumLL * decay + ll;
+    sumRR = sumRR * decay + rr;
+}
+
+void StereoAnalyser::renderFrame(float elapsedSeconds)
+{
+    auto decay = std::exp(-elapsedSeconds / fadeTime);
+    auto colour = juce::Colour(140u, 200u, 190u);
+    
+    juce::Image::BitmapData pixels(image, juce::Image::BitmapData::writeOnly);
+    
+    for (int y = 0; y < imageSize; ++y)
+    {
+        for (int x = 0; x < imageSize; ++x)
+        {
+            auto& value = intensity[static_cast<size_t>(y * imageSize + x)];
+            value *= decay;
+            
+            //Saturates, so a dense trace doesn't hide the rest
+            pixels.setPixelColour(x, y, colour.withAlpha(1.f - std::exp(-0.5f * value)));
+        }
+    }
+}
+
+float StereoAnalyser::getCorrelation() const
+{
+    auto energy = std::sqrt(sumLL * sumRR);
+    return energy > 1.0e-12 ? static_cast<float>(sumLR / energy) : 0.f;
+}
+
+GoniometerComponent::GoniometerComponent(const StereoAnalyser& analyserToShow) :
+analyser(analyserToShow)
+{
+    startTimerHz(30);
+}
+
+void GoniometerComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    auto bounds = getLocalBounds().reduced(2);
+    auto correlationArea = bounds.removeFromBottom(14);
+    auto scope = bounds.withSizeKeepingCentre(jmin(bounds.getWidth(), bounds.getHeight()),
+                                              jmin(bounds.getWidth(), bounds.getHeight())).toFloat();
+    
+    g.setColour(Colour(43u, 36u, 48u));
+    g.fillRect(scope);
+    g.drawImage(analyser.getImage(), scope);
+    
+    //The L and R axes, at 45 degrees either side of mid
+    g.setColour(Colours::dimgrey);
+    g.drawLine(scope.getX(), scope.getY(), scope.getRight(), scope.getBottom(), 0.5f);
+    g.drawLine(scope.getRight(), scope.getY(), scope.getX(), scope.getBottom(), 0.5f);
+    
+    //-1 on the left, +1 on the right
+    auto correlation = analyser.getCorrelation();
+    auto bar = correlationArea.reduced(0, 3).toFloat();
+    g.setColour(Colour(43u, 36u, 48u));
+    g.fillRect(bar);
+    
+    auto centreX = bar.getCentreX();
+    auto valueX = jmap(correlation, -1.f, 1.f, bar.getX(), bar.getRight());
+    g.setColour(correlation < 0.f ? Colours::red : Colour(140u, 200u, 190u));
+    g.fillRect(Rectangle<float>::leftTopRightBottom(jmin(centreX, valueX), bar.getY(), jmax(centreX, valueX), bar.getBottom()));
+}
+
 //==============================================================================
 ResponseCurveComponent::ResponseCurveComponent(ZooEQAudioProcessor& p) :
 audioProcessor(p),
@@ -316,19 +407,30 @@ void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
     {
         if ( leftChannelFifo->getAudioBuffer(tempIncomingBuffer) )
         {
-            auto size = tempIncomingBuffer.getNumSamples();
-            
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                                              monoBuffer.getReadPointer(0, size),
-                                              monoBuffer.getNumSamples() - size);
-            
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                              tempIncomingBuffer.getReadPointer(0, 0),
-                                              size);
-            
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+            addBuffer(tempIncomingBuffer);
         }
     }
+    
+    generatePath(fftBounds, sampleRate);
+}
+
+void PathProducer::addBuffer(const juce::AudioBuffer<float>& incoming)
+{
+    auto size = incoming.getNumSamples();
+    
+    juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
+                                      monoBuffer.getReadPointer(0, size),
+                                      monoBuffer.getNumSamples() - size);
+    
+    juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
+                                      incoming.getReadPointer(0, 0),
+                                      size);
+    
+    leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+}
+
+void PathProducer::generatePath(juce::Rectangle<float> fftBounds, double sampleRate)
+{
     /**
      if there are FFT data buffers to pull
         if we can pull a buffer
@@ -367,10 +469,15 @@ void ResponseCurveComponent::timerCallback()
         auto fftBounds = getAnalysisArea().toFloat();
         auto sampleRate = audioProcessor.getSampleRate();
         
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+        drainAnalyserFifos(sampleRate);
+        leftPathProducer.generatePath(fftBounds, sampleRate);
+        rightPathProducer.generatePath(fftBounds, sampleRate);
     }
     
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    stereoAnalyser.renderFrame(static_cast<float>((now - lastFrameMs) * 0.001));
+    lastFrameMs = now;
+    
     if ( parametersChanged.compareAndSetBool(false, true) )
     {
         updateChain();
@@ -378,6 +485,25 @@ void ResponseCurveComponent::timerCallback()
     repaint();
 }
 
+void ResponseCurveComponent::drainAnalyserFifos(double sampleRate)
+{
+    auto& leftFifo = audioProcessor.leftChannelFifo;
+    auto& rightFifo = audioProcessor.rightChannelFifo;
+    juce::AudioBuffer<float> left, right;
+    
+    //Both fifos are filled from the same blocks, so their buffers pair up in order
+    while (leftFifo.getNumCompleteBuffersAvailable() > 0 && rightFifo.getNumCompleteBuffersAvailable() > 0)
+    {
+        if (leftFifo.getAudioBuffer(left) && rightFifo.getAudioBuffer(right))
+        {
+            leftPathProducer.addBuffer(left);
+            rightPathProducer.addBuffer(right);
+            stereoAnalyser.addSamples(left.getReadPointer(0), right.getReadPointer(0),
+                                      juce::jmin(left.getNumSamples(), right.getNumSamples()), sampleRate);
+        }
+    }
+}
+
 void ResponseCurveComponent::updateChain()
 {
     //update the monochain
@@ -692,6 +818,7 @@ lowCutSlopeSlider(*audioProcessor.apvts.getParameter("LowCut Slope"), "dB/Oct"),
 highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
 
 responseCurveComponent(audioProcessor),
+goniometerComponent(responseCurveComponent.getStereoAnalyser()),
 
 peakFreqSliderAttachment(audioProcessor.apvts, "Peak Freq", peakFreqSlider),
 peakGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakGainSlider),
@@ -704,7 +831,14 @@ highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlope
 lowcutBypassButtonAttachment(audioProcessor.apvts, "LowCut Bypassed", lowcutBypassButton),
 peakBypassButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassButton),
 highcutBypassButtonAttachment(audioProcessor.apvts, "HighCut Bypassed", highcutBypassButton),
-analyserEnableButtonAttachment(audioProcessor.apvts, "Analyser Enable", analyserEnableButton)
+analyserEnableButtonAttachment(audioProcessor.apvts, "Analyser Enable", analyserEnableButton),
+truePeakButtonAttachment(audioProcessor.apvts, "TruePeak Enable", truePeakButton),
+midSideButtonAttachment(audioProcessor.apvts, "MidSide Enable", midSideButton),
+spectralCutsButtonAttachment(audioProcessor.apvts, "Spectral Cuts", spectralCutsButton),
+
+inputMeterComponent(audioProcessor.inputMeter, "IN"),
+outputMeterComponent(audioProcessor.outputMeter, "OUT"),
+loudnessDisplay(audioProcessor.outputLoudness)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
@@ -784,7 +918,9 @@ analyserEnableButtonAttachment(audioProcessor.apvts, "Analyser Enable", analyser
         }
     };
     
-    setSize (600, 400); //Size of the window
+    outputMeterComponent.showTruePeak(audioProcessor.truePeakMeter, *audioProcessor.apvts.getParameter("TruePeak Enable"));
+    
+    setSize (660, 400); //Size of the window
 }
 
 ZooEQAudioProcessorEditor::~ZooEQAudioProcessorEditor()
@@ -795,6 +931,127 @@ ZooEQAudioProcessorEditor::~ZooEQAudioProcessorEditor()
     analyserEnableButton.setLookAndFeel(nullptr);
 }
 
+//==============================================================================
+void MeterBallistics::update(const LevelMeter::Reading& reading, float elapsedSeconds)
+{
+    auto blockPeakDb = juce::Decibels::gainToDecibels(reading.peak, minusInfinityDb);
+    peakDb = juce::jmax(blockPeakDb, peakDb - peakFallRate * elapsedSeconds, minusInfinityDb);
+    
+    //One pole on the power, so the RMS reads the same for any repaint rate
+    auto coefficient = 1.f - std::exp(-elapsedSeconds / rmsTime);
+    meanSquare += coefficient * (reading.meanSquare - meanSquare);
+}
+
+float MeterBallistics::getRmsDb() const
+{
+    return juce::Decibels::gainToDecibels(std::sqrt(meanSquare), minusInfinityDb);
+}
+
+LevelMeterComponent::LevelMeterComponent(LevelMeter& meterToShow, const juce::String& meterName) :
+meter(meterToShow),
+name(meterName)
+{
+    startTimerHz(30);
+}
+
+void LevelMeterComponent::showTruePeak(TruePeakMeter& meterToShow, juce::RangedAudioParameter& enableParameter)
+{
+    truePeakMeter = &meterToShow;
+    truePeakEnable = &enableParameter;
+}
+
+void LevelMeterComponent::timerCallback()
+{
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto elapsedSeconds = static_cast<float>((now - lastUpdateMs) * 0.001);
+    lastUpdateMs = now;
+    
+    auto showingTruePeak = isShowingTruePeak();
+    
+    for (int channel = 0; channel < LevelMeter::numChannels; ++channel)
+    {
+        auto reading = meter.take(channel);
+        
+        //The interpolated peak is never meant to read below the sample peak
+        if (showingTruePeak)
+            reading.peak = juce::jmax(reading.peak, truePeakMeter->take(channel));
+        
+        ballistics[static_cast<size_t>(channel)].update(reading, elapsedSeconds);
+    }
+    
+    repaint();
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    auto bounds = getLocalBounds();
+    auto textHeight = 14;
+    
+    g.setColour(Colour(43u, 36u, 48u));
+    g.setFont(static_cast<float>(textHeight - 2));
+    auto title = name;
+    if (isShowingTruePeak())
+    {
+        auto truePeakDb = jmax(ballistics[0].getPeakDb(), ballistics[1].getPeakDb());
+        title = truePeakDb > MeterBallistics::minusInfinityDb ? String(truePeakDb, 1) : String("TP");
+    }
+    g.drawFittedText(title, bounds.removeFromTop(textHeight), Justification::centred, 1);
+    
+    //The crest factor of the louder channel
+    auto& loudest = ballistics[0].getRmsDb() >= ballistics[1].getRmsDb() ? ballistics[0] : ballistics[1];
+    auto crest = loudest.getRmsDb() > MeterBallistics::minusInfinityDb ? String(loudest.getCrestDb(), 1) : String("-");
+    g.drawFittedText(crest, bounds.removeFromBottom(textHeight), Justification::centred, 1);
+    
+    auto map = [&bounds](float db)
+    {
+        return jmap(db, MeterBallistics::minusInfinityDb, 6.f, static_cast<float>(bounds.getBottom()),
+                    static_cast<float>(bounds.getY()));
+    };
+    
+    auto barWidth = bounds.getWidth() / LevelMeter::numChannels;
+    for (int channel = 0; channel < LevelMeter::numChannels; ++channel)
+    {
+        auto& channelBallistics = ballistics[static_cast<size_t>(channel)];
+        auto bar = bounds.withX(bounds.getX() + channel * barWidth).withWidth(barWidth).reduced(2, 0).toFloat();
+        
+        g.setColour(Colour(43u, 36u, 48u));
+        g.fillRect(bar);
+        
+        g.setColour(Colour(140u, 200u, 190u));
+        g.fillRect(bar.withTop(map(channelBallistics.getRmsDb())));
+        
+        auto peakY = map(channelBallistics.getPeakDb());
+        g.setColour(channelBallistics.getPeakDb() > 0.f ? Colours::red : Colours::white);
+        g.drawHorizontalLine(roundToInt(peakY), bar.getX(), bar.getRight());
+    }
+}
+
+LoudnessDisplay::LoudnessDisplay(LoudnessMeter& meterToShow) :
+meter(meterToShow)
+{
+    startTimerHz(10);
+}
+
+void LoudnessDisplay::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    auto format = [](float lufs)
+    {
+        return lufs > LoudnessMeter::absoluteGate ? String(lufs, 1) : String("-inf");
+    };
+    
+    auto text = "M " + format(meter.getMomentaryLoudness())
+              + "   S " + format(meter.getShortTermLoudness())
+              + "   I " + format(meter.getIntegratedLoudness()) + " LUFS";
+    
+    g.setColour(Colour(43u, 36u, 48u));
+    g.setFont(12.f);
+    g.drawFittedText(text, getLocalBounds(), Justification::centred, 1);
+}
+
 //==============================================================================
 void ZooEQAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -816,6 +1073,12 @@ void ZooEQAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
     
     auto analyzerEnableArea = bounds.removeFromTop(25);
+    auto truePeakArea = analyzerEnableArea.withTrimmedTop(2).withTrimmedRight(20);
+    truePeakButton.setBounds(truePeakArea.removeFromRight(90));
+    midSideButton.setBounds(truePeakArea.removeFromRight(90));
+    spectralCutsButton.setBounds(truePeakArea.removeFromRight(90));
+    loudnessDisplay.setBounds(truePeakArea.withTrimmedLeft(80));
+    
     analyzerEnableArea.setWidth(40 /*JUCE_LIVE_CONSTANT(50)*/);
     analyzerEnableArea.setX( 20 /*JUCE_LIVE_CONSTANT(5)*/); //To don't be glue to the left bound window
     analyzerEnableArea.removeFromTop(2); //To don't be glue to the top bound window
@@ -823,8 +1086,13 @@ void ZooEQAudioProcessorEditor::resized()
     
     bounds.removeFromTop(5);
     
+    //Input meter on the left, output meter on the right, over the full height
+    inputMeterComponent.setBounds(bounds.removeFromLeft(30));
+    outputMeterComponent.setBounds(bounds.removeFromRight(30));
+    
     float hRatio = 32.f / 100.f;// JUCE_LIVE_CONSTANT(33) / 100.f;
     auto responseArea = bounds.removeFromTop(static_cast<int>(bounds.getHeight() * hRatio));
+    goniometerComponent.setBounds(responseArea.removeFromRight(responseArea.getHeight()));
     responseCurveComponent.setBounds(responseArea);
     
     bounds.removeFromTop(5); //Create a gap between response curve and sliders
@@ -857,9 +1125,16 @@ std::vector<juce::Component*> ZooEQAudioProcessorEditor::getComps()
         &lowCutSlopeSlider,
         &highCutSlopeSlider,
         &responseCurveComponent,
+        &goniometerComponent,
         &lowcutBypassButton,
         &peakBypassButton,
         &highcutBypassButton,
-        &analyserEnableButton
+        &analyserEnableButton,
+        &truePeakButton,
+        &midSideButton,
+        &spectralCutsButton,
+        &inputMeterComponent,
+        &outputMeterComponent,
+        &loudnessDisplay
     };
 }
@@ -25,6 +25,17 @@ struct FFTDataGenerator
         Produces the FFT data from an audio buffer
      */
     void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    {
+        performFFT(audioData);
+        convertToDecibels(negativeInfinity);
+        
+        fftDataFifo.push(fftData);
+    }
+    
+    /**
+        Windows the audio and computes its normalised magnitude spectrum
+     */
+    void performFFT(const juce::AudioBuffer<float>& audioData)
     {
         const auto fftSize = getFFTSize();
         
@@ -45,16 +56,21 @@ struct FFTDataGenerator
         {
             fftData[static_cast<std::vector<float>::size_type>(i)] /= (float) numBins;
         }
+    }
+    
+    /**
+        Converts the spectrum computed by performFFT() to decibels
+     */
+    void convertToDecibels(const float negativeInfinity)
+    {
+        int numBins = (int)getFFTSize() / 2;
         
         //Conversion then to decibel
-        for( int i = 0; i<numBins; ++i )
-        {
-            fftData[static_cast<std::vector<float>::size_type>(i)] = juce::Decibels::gainToDecibels(fftData[static_cast<std::vector<float>::size_type>(i)], negativeInfinity);
-        }
-        
-        fftDataFifo.push(fftData);
+        kernels->gainToDecibels(fftData.data(), numBins, negativeInfinity);
     }
     
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
     void changeOrder(FFTOrder newOrder)
     {
         order = newOrder;
@@ -74,9 +90,11 @@ struct FFTDataGenerator
     int getNumAvailableFFTDataBlocks() const {return fftDataFifo.getNumAvailableForReading();}
     //==============================================================================
     bool getFFTData(BlockType& result) {return fftDataFifo.pull(result);}
+    const BlockType& getRenderData() const {return fftData;}
 private:
     FFTOrder order;
     BlockType fftData;
+    const DspKernels* kernels = &selectDspKernels();
     std::unique_ptr<juce::dsp::FFT> forwardFFT;
     std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
     Fifo<BlockType> fftDataFifo;
@@ -206,9 +224,22 @@ struct PathProducer
         leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
         monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
     }
+    /** Drains the channel's fifo into the FFT, then updates the path */
     void process(juce::Rectangle<float> fftBounds, double sampleRate);
+    
+    /** The two halves of process(), for a caller that drains the fifo itself */
+    void addBuffer(const juce::AudioBuffer<float>& incoming);
+    void generatePath(juce::Rectangle<float> fftBounds, double sampleRate);
+    
     juce::Path getPath() { return leftChannelFFTPath; }
     
+    void changeOrder(FFTOrder newOrder)
+    {
+        leftChannelFFTDataGenerator.changeOrder(newOrder);
+        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        monoBuffer.clear();
+    }
+    
 private:
     SingleChannelSampleFifo<ZooEQAudioProcessor::BlockType>* leftChannelFifo;
     
@@ -221,6 +252,42 @@ private:
     juce::Path leftChannelFFTPath;
 };
 
+/**
+    Correlation and goniometer of the analyser's two channels, computed on the message
+    thread from the buffers the path producers pull. The goniometer accumulates hits into
+    a small intensity map that decays on every frame, and only that map is turned into
+    an image, so painting it is a single drawImage() whatever the number of samples.
+ */
+struct StereoAnalyser
+{
+    static constexpr int imageSize = 128;
+    static constexpr float correlationTime = 0.3f; //seconds
+    static constexpr float fadeTime = 0.15f;       //seconds for the image to fall to 1/e
+    
+    void addSamples(const float* left, const float* right, int numSamples, double sampleRate);
+    void renderFrame(float elapsedSeconds);
+    
+    /** +1 for mono, 0 for unrelated channels, -1 for opposite polarity */
+    float getCorrelation() const;
+    const juce::Image& getImage() const { return image; }
+    
+private:
+    std::vector<float> intensity = std::vector<float>(static_cast<size_t>(imageSize * imageSize), 0.f);
+    juce::Image image { juce::Image::ARGB, imageSize, imageSize, true };
+    double sumLR = 0, sumLL = 0, sumRR = 0;
+};
+
+struct GoniometerComponent : juce::Component, juce::Timer
+{
+    explicit GoniometerComponent(const StereoAnalyser& analyserToShow);
+    
+    void timerCallback() override { repaint(); }
+    void paint(juce::Graphics& g) override;
+    
+private:
+    const StereoAnalyser& analyser;
+};
+
 struct ResponseCurveComponent: juce::Component,
 juce::AudioProcessorParameter::Listener,
 juce::Timer
@@ -243,6 +310,14 @@ juce::Timer
         shouldShowFFTAnalysis = enabled;
     }
     
+    void setFFTOrder(FFTOrder newOrder)
+    {
+        leftPathProducer.changeOrder(newOrder);
+        rightPathProducer.changeOrder(newOrder);
+    }
+    
+    const StereoAnalyser& getStereoAnalyser() const { return stereoAnalyser; }
+    
 private:
     ZooEQAudioProcessor& audioProcessor;
     juce::Atomic<bool> parametersChanged { false };
@@ -258,6 +333,11 @@ private:
     juce::Rectangle<int> getAnalysisArea();
     
     PathProducer leftPathProducer, rightPathProducer;
+    StereoAnalyser stereoAnalyser;
+    double lastFrameMs = juce::Time::getMillisecondCounterHiRes();
+    
+    //Pulls both channels in step, so the stereo analysis sees the samples the paths do
+    void drainAnalyserFifos(double sampleRate);
     
     bool shouldShowFFTAnalysis = true;
 };
@@ -285,6 +365,66 @@ struct AnalyserButton : juce::ToggleButton
     juce::Path randomPath;
 };
 
+/**
+    Meter ballistics for the LevelMeter readings, applied on the message thread: the peak
+    jumps up and falls back at peakFallRate, the RMS integrates over rmsTime.
+ */
+struct MeterBallistics
+{
+    static constexpr float minusInfinityDb = -60.f;
+    static constexpr float peakFallRate = 20.f; //dB per second
+    static constexpr float rmsTime = 0.3f;      //seconds
+    
+    void update(const LevelMeter::Reading& reading, float elapsedSeconds);
+    
+    float getPeakDb() const { return peakDb; }
+    float getRmsDb() const;
+    float getCrestDb() const { return peakDb - getRmsDb(); }
+    
+private:
+    float peakDb = minusInfinityDb;
+    float meanSquare = 0;
+};
+
+/**
+    Two bars, one per channel, with the RMS filled in, the peak as a line and the crest
+    factor below. With a true-peak meter that is enabled, the line and the name show the
+    true peak instead.
+ */
+struct LevelMeterComponent : juce::Component, juce::Timer
+{
+    LevelMeterComponent(LevelMeter& meterToShow, const juce::String& meterName);
+    
+    void showTruePeak(TruePeakMeter& meterToShow, juce::RangedAudioParameter& enableParameter);
+    
+    void timerCallback() override;
+    void paint(juce::Graphics& g) override;
+    
+private:
+    LevelMeter& meter;
+    juce::String name;
+    std::array<MeterBallistics, LevelMeter::numChannels> ballistics;
+    double lastUpdateMs = juce::Time::getMillisecondCounterHiRes();
+    
+    TruePeakMeter* truePeakMeter = nullptr;
+    juce::RangedAudioParameter* truePeakEnable = nullptr;
+    
+    bool isShowingTruePeak() const { return truePeakMeter != nullptr && truePeakEnable->getValue() > 0.5f; }
+};
+
+//Momentary, short-term and integrated loudness of the output, clicking restarts the integrated one
+struct LoudnessDisplay : juce::Component, juce::Timer
+{
+    explicit LoudnessDisplay(LoudnessMeter& meterToShow);
+    
+    void timerCallback() override { repaint(); }
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent&) override { meter.resetIntegrated(); }
+    
+private:
+    LoudnessMeter& meter;
+};
+
 class ZooEQAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
@@ -309,6 +449,7 @@ private:
     highCutSlopeSlider;
     
     ResponseCurveComponent responseCurveComponent;
+    GoniometerComponent goniometerComponent;
     
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
@@ -322,13 +463,22 @@ private:
     
     PowerButton lowcutBypassButton, peakBypassButton, highcutBypassButton;
     AnalyserButton analyserEnableButton;
+    juce::ToggleButton truePeakButton { "True Peak" };
+    juce::ToggleButton midSideButton { "Mid/Side" };
+    juce::ToggleButton spectralCutsButton { "Brickwall" };
     
     
     using ButtonAttachment = APVTS::ButtonAttachment;
     ButtonAttachment    lowcutBypassButtonAttachment,
                         peakBypassButtonAttachment,
                         highcutBypassButtonAttachment,
-                        analyserEnableButtonAttachment;
+                        analyserEnableButtonAttachment,
+                        truePeakButtonAttachment,
+                        midSideButtonAttachment,
+                        spectralCutsButtonAttachment;
+    
+    LevelMeterComponent inputMeterComponent, outputMeterComponent;
+    LoudnessDisplay loudnessDisplay;
     
     std::vector<juce::Component*> getComps();
     
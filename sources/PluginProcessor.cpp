@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "StateFormat.h"
 
 //==============================================================================
 ZooEQAudioProcessor::ZooEQAudioProcessor()
@@ -22,10 +23,27 @@ ZooEQAudioProcessor::ZooEQAudioProcessor()
                        )
 #endif
 {
+    //Mapped, not read, so a large bank costs nothing until a preset is used
+    presetBank.open(PresetBank::getDefaultFile());
+    
+    for (size_t i = 0; i < chainParameterIDs.size(); ++i)
+    {
+        auto* param = apvts.getParameter(chainParameterIDs[i]);
+        jassert(param != nullptr);
+        chainParameters[i] = param;
+        param->addListener(this);
+    }
+    
+    //Follows "Spectral Cuts" with the latency reported to the host
+    startTimerHz(10);
 }
 
 ZooEQAudioProcessor::~ZooEQAudioProcessor()
 {
+    stopTimer();
+    
+    for (auto* param : chainParameters)
+        param->removeListener(this);
 }
 
 //==============================================================================
@@ -68,31 +86,61 @@ double ZooEQAudioProcessor::getTailLengthSeconds() const
 
 int ZooEQAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, presetBank.getNumPresets());
 }
 
 int ZooEQAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void ZooEQAudioProcessor::setCurrentProgram(int index)
 {
-    juce::ignoreUnused(index);
+    //Only the preset's own record is read, and it's a binary state: no XML, no ValueTree
+    const void* state = nullptr;
+    size_t stateSize = 0;
+    
+    if (presetBank.getState(index, state, stateSize) && readBinaryState(apvts, morphSnapshots, state, stateSize))
+    {
+        morphSnapshotFifo.push(morphSnapshots);
+        currentProgram = index;
+    }
 }
 
 const juce::String ZooEQAudioProcessor::getProgramName(int index)
 {
-    juce::ignoreUnused(index);
-    return {};
+    return presetBank.getName(index);
 }
 
 void ZooEQAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    //The bank is mapped read-only, it's edited by writing a new one with PresetBank::write()
     juce::ignoreUnused(index, newName);
 }
 
+bool ZooEQAudioProcessor::loadPresetBank(const juce::File& file)
+{
+    currentProgram = 0;
+    return presetBank.open(file);
+}
+
+void ZooEQAudioProcessor::setMorphSnapshot(int slot, const ChainSettings& settings)
+{
+    jassert(slot == 0 || slot == 1);
+    
+    (slot == 0 ? morphSnapshots.a : morphSnapshots.b) = settings;
+    (slot == 0 ? morphSnapshots.hasA : morphSnapshots.hasB) = true;
+    morphSnapshotFifo.push(morphSnapshots);
+}
+
+void ZooEQAudioProcessor::clearMorphSnapshots()
+{
+    morphSnapshots = {};
+    morphSnapshotFifo.push(morphSnapshots);
+}
+
 //==============================================================================
 void ZooEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
@@ -101,21 +149,83 @@ void ZooEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     
     juce::dsp::ProcessSpec spec;
     
-    spec.maximumBlockSize = static_cast<juce::uint32>(samplesPerBlock);
+    //Hosts don't always keep to samplesPerBlock, but processBlock() never hands more than
+    //a sub-block to anything
+    juce::ignoreUnused(samplesPerBlock);
+    spec.maximumBlockSize = static_cast<juce::uint32>(subBlockSize);
     
     spec.numChannels=1;
     
     spec.sampleRate=sampleRate;
     
+    // === Filter Processing === //
+    //Designed before preparing, so the filters size their state for second order sections
+    //here rather than on the first processBlock()
+    designedSampleRate = 0;
+    updateFilters();
+    automationResync = true;
+    
     leftChain.prepare(spec);
     rightChain.prepare(spec);
     
-    // === Filter Processing === //
-    updateFilters();
+    //The chains hold the coefficients, the cascades run them with the best kernels for this CPU
+    auto& kernels = forcedInstructionSet.has_value() ? selectDspKernels(*forcedInstructionSet)
+                                                     : selectDspKernels();
+    leftCascade.setKernels(kernels);
+    rightCascade.setKernels(kernels);
+    leftCascade.reset();
+    rightCascade.reset();
+    dualMono = DualMonoFilters::none;
+    
+    leftSvf.prepare(sampleRate);
+    rightSvf.prepare(sampleRate);
+    
+    //The morph only ever processes one control interval at a time
+    morphTarget.leftCascade.setKernels(kernels);
+    morphTarget.rightCascade.setKernels(kernels);
+    morphTarget.leftCascade.reset();
+    morphTarget.rightCascade.reset();
+    morphTarget.leftSvf.prepare(sampleRate);
+    morphTarget.rightSvf.prepare(sampleRate);
+    morphBuffer.setSize(2, morphControlInterval);
+    morphAmount = apvts.getRawParameterValue("Morph")->load();
+    
+    compareSlots.setKernels(kernels);
+    inputMeter.setKernels(kernels);
+    outputMeter.setKernels(kernels);
+    truePeakMeter.setKernels(kernels);
+    truePeakMeter.reset();
+    
+    inputLoudness.setKernels(kernels);
+    outputLoudness.setKernels(kernels);
+    inputLoudness.prepare(sampleRate);
+    outputLoudness.prepare(sampleRate);
+    compensationGain.reset(sampleRate, 0.5);
+    compensationGain.setCurrentAndTargetValue(1.0f);
+    compareSlots.prepare(sampleRate);
+    
+    spectralCuts.prepare(sampleRate);
+    spectralCutsLatency = spectralCuts.getLatency();
+    spectralCutsActive = apvts.getRawParameterValue("Spectral Cuts")->load() > 0.5f;
+    setLatencySamples(getSpectralCutsLatency());
+    
+    //Designed here so playback starts in parallel, then the designer thread follows the settings
+    parallelDesign = designParallelSections(getChainSettings(apvts), sampleRate);
+    leftParallel.setKernels(kernels);
+    rightParallel.setKernels(kernels);
+    leftParallel.reset();
+    rightParallel.reset();
+    parallelDesigner.start();
+    
+    liveFilters = fadingFilters = DualMonoFilters::none;
+    filterFadeLength = juce::jmax(1, juce::roundToInt(CompareSlots::fadeTime * sampleRate));
+    filterFadeRemaining = 0;
+    filterFadeBuffer.setSize(2, subBlockSize);
     
     // === Fifo process === //
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    //The analyser gets a buffer per sub-block, whatever the host's block size
+    leftChannelFifo.prepare(subBlockSize);
+    rightChannelFifo.prepare(subBlockSize);
     
     osc.initialise([](float x) { return std::sin(x); } );
     
@@ -129,6 +239,7 @@ void ZooEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    parallelDesigner.stop();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -173,23 +284,439 @@ void ZooEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // === Filter Processing === //
-    updateFilters();
+    auto engine = getFilterEngine(isNonRealtime());
+    const auto& profile = getProcessingProfile(isNonRealtime());
+    
+    while (morphSnapshotFifo.pull(playingMorphSnapshots))
+        ;
+    
+    //Changes made while this block plays are stamped relative to its start, see parameterValueChanged()
+    audioThreadId = juce::Thread::getCurrentThreadId();
+    blockStartTime = juce::Time::getMillisecondCounterHiRes();
+    
+    //After a dropped change or a reset the parameters are read as they are, like before automation was queued
+    if (automationResync.exchange(false))
+    {
+        automation.clear();
+        automatedSettings = getChainSettings(apvts);
+    }
+    
+    updateSpectralCuts();
+    automation.beginBlock(buffer.getNumSamples(), profile.maxAutomationSplits);
+    
+    //Hosts send anything from one sample to thousands, whatever prepareToPlay() said, so the
+    //work is done in sub-blocks of at most subBlockSize that stay in cache and update at the same rate.
+    //They are also split where a parameter changes, so its automation is sample accurate.
+    for (int offset = 0; offset < buffer.getNumSamples(); )
+    {
+        const auto end = automation.advance(automatedSettings, offset, juce::jmin(subBlockSize, buffer.getNumSamples() - offset));
+        juce::AudioBuffer<float> subBlock(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, end - offset);
+        processSubBlock(subBlock, automatedSettings, engine, profile);
+        offset = end;
+    }
+    
+    automation.endBlock(automatedSettings);
+}
+
+void ZooEQAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    for (size_t i = 0; i < chainParameters.size(); ++i)
+    {
+        if (chainParameters[i]->getParameterIndex() != parameterIndex)
+            continue;
+        
+        ParameterChange change;
+        change.parameter = static_cast<ChainParameter>(i);
+        change.value = chainParameters[i]->convertFrom0to1(newValue);
+        
+        //Hosts automate on the audio thread between blocks, so those changes are due at the start of the
+        //next one. Other threads are stamped with the time since this block started and play that far
+        //into the next, one block late but spaced as they were made, like juce::MidiMessageCollector does.
+        const auto fromAudioThread = juce::Thread::getCurrentThreadId() == audioThreadId.load();
+        if (! fromAudioThread)
+        {
+            const auto elapsed = (juce::Time::getMillisecondCounterHiRes() - blockStartTime.load()) * 0.001;
+            change.offset = static_cast<int>(juce::jmax(0.0, elapsed * getSampleRate()));
+        }
+        
+        if (! automation.push(change, fromAudioThread))
+            automationResync = true;
+        
+        return;
+    }
+}
+
+void ZooEQAudioProcessor::updateSpectralCuts()
+{
+    const auto active = apvts.getRawParameterValue("Spectral Cuts")->load() > 0.5f;
+    
+    if (active == spectralCutsActive)
+        return;
+    
+    //Starts from silence rather than from whatever was playing when it was last on.
+    //The host hears about the latency from timerCallback().
+    spectralCuts.reset();
+    spectralCutsActive = active;
+}
+
+int ZooEQAudioProcessor::getSpectralCutsLatency() const
+{
+    return apvts.getRawParameterValue("Spectral Cuts")->load() > 0.5f ? spectralCutsLatency.load() : 0;
+}
+
+void ZooEQAudioProcessor::timerCallback()
+{
+    const auto latency = getSpectralCutsLatency();
+    
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+static ChainSettings withoutCuts(ChainSettings settings)
+{
+    settings.lowCutBypassed = true;
+    settings.highCutBypassed = true;
+    return settings;
+}
+
+void ZooEQAudioProcessor::processSubBlock(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, FilterEngine engine,
+                                          const ProcessingProfile& profile)
+{
+    if (profile.levelMeters)
+        inputMeter.measure(buffer);
+    
+    inputLoudness.measure(buffer);
+    
+    //The spectral cuts take over from the IIR ones, which the filters then leave out
+    const auto liveSettings = spectralCutsActive ? withoutCuts(chainSettings) : chainSettings;
     
     // === Apply FX on the audio === //
-    juce::dsp::AudioBlock<float> block(buffer);
+    //A compare slot replaces the parameters, which only play while fading to or from them
+    compareSlots.update();
+    
+    if (compareSlots.isActive())
+    {
+        compareSlots.process(buffer, engine, [this, &liveSettings, engine, &profile](juce::AudioBuffer<float>& block)
+        {
+            processLive(block, liveSettings, engine, profile);
+        });
+    }
+    else
+    {
+        processLive(buffer, liveSettings, engine, profile);
+    }
+    
+    if (spectralCutsActive)
+        spectralCuts.process(buffer, chainSettings, apvts.getRawParameterValue("Spectral Transition")->load());
+    
+    outputLoudness.measure(buffer);
+    applyLoudnessCompensation(buffer);
+    
+    if (profile.levelMeters)
+    {
+        //The output meter fills the analyser fifos in the pass it measures the level with
+        if (profile.analyserTap)
+            outputMeter.measure(buffer, leftChannelFifo, rightChannelFifo);
+        else
+            outputMeter.measure(buffer);
+        
+        truePeakMeter.measure(buffer, apvts.getRawParameterValue("TruePeak Enable")->load() > 0.5f);
+    }
+    else if (profile.analyserTap)
+    {
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
+}
+
+void ZooEQAudioProcessor::applyLoudnessCompensation(juce::AudioBuffer<float>& buffer)
+{
+    auto target = 1.0f;
+    
+    if (loudnessCompensation)
+    {
+        auto input = inputLoudness.getShortTermLoudness();
+        auto output = outputLoudness.getShortTermLoudness();
+        
+        //Holds the last gain through silence, where there is nothing to match
+        if (input <= LoudnessMeter::absoluteGate || output <= LoudnessMeter::absoluteGate)
+            target = compensationGain.getTargetValue();
+        else
+            target = juce::Decibels::decibelsToGain(juce::jlimit(-24.0f, 24.0f, input - output));
+    }
+    
+    compensationGain.setTargetValue(target);
+    compensationGain.applyGain(buffer, buffer.getNumSamples());
+}
+
+void ZooEQAudioProcessor::processLive(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, FilterEngine engine,
+                                      const ProcessingProfile& profile)
+{
+    if (playingMorphSnapshots.isComplete())
+    {
+        //The morph runs the cascades on both channels itself
+        endDualMono();
+        processMorph(buffer, engine, profile.morphInterval);
+        liveFilters = DualMonoFilters::none;
+        return;
+    }
+    
+    if (apvts.getRawParameterValue("MidSide Enable")->load() > 0.5f)
+    {
+        //Mid and side are never the same, and the side is silent for dual mono anyway
+        endDualMono();
+        
+        //The spectral cuts apply to left and right afterwards, so the side's own cuts are left out
+        //too rather than cutting it twice
+        const auto sideSettings = getSideChainSettings(apvts);
+        processMidSide(buffer, chainSettings, spectralCutsActive ? withoutCuts(sideSettings) : sideSettings, engine);
+        liveFilters = DualMonoFilters::none;
+        return;
+    }
+    
+    //The parallel form falls back to the cascade whenever its design isn't accurate enough
+    auto filters = DualMonoFilters::cascade;
+    if (topology == FilterTopology::parallel && updateParallelDesign(chainSettings))
+        filters = DualMonoFilters::parallel;
+    else if (engine == FilterEngine::stateVariable)
+        filters = DualMonoFilters::stateVariable;
+    
+    //Whatever the new filters last played may be minutes old, so they start from silence and
+    //fade in over the ones that were playing. Switching back mid-fade keeps the state they have.
+    if (filters != liveFilters && liveFilters != DualMonoFilters::none)
+    {
+        if (filters != fadingFilters || filterFadeRemaining == 0)
+            resetFilters(filters);
+        
+        fadingFilters = liveFilters;
+        filterFadeRemaining = filterFadeLength;
+    }
+    
+    liveFilters = filters;
     
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    if (filterFadeRemaining == 0)
+    {
+        processFilters(filters, buffer, chainSettings, engine, parallelDesign);
+        
+        if (filters == DualMonoFilters::parallel)
+            fadingDesign = parallelDesign;
+        
+        return;
+    }
+    
+    //The old filters only run until the fade ends, the new ones through the whole sub-block
+    jassert(buffer.getNumSamples() <= filterFadeBuffer.getNumSamples());
+    const auto numSamples = buffer.getNumSamples();
+    const auto length = juce::jmin(numSamples, filterFadeRemaining);
+    
+    float* fadeChannels[] = { filterFadeBuffer.getWritePointer(0), filterFadeBuffer.getWritePointer(1) };
+    juce::AudioBuffer<float> fadingOut(fadeChannels, 2, length);
+    fadingOut.copyFrom(0, 0, buffer, 0, 0, length);
+    fadingOut.copyFrom(1, 0, buffer, 1, 0, length);
+    
+    processFilters(fadingFilters, fadingOut, chainSettings, engine, fadingDesign);
+    processFilters(filters, buffer, chainSettings, engine, parallelDesign);
     
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    //Linear like the compare slots, both are the same input filtered two ways
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* output = buffer.getWritePointer(channel);
+        const auto* old = fadingOut.getReadPointer(channel);
+        
+        for (int i = 0; i < length; ++i)
+        {
+            const auto gain = 1.0f - static_cast<float>(filterFadeRemaining - i) / static_cast<float>(filterFadeLength);
+            output[i] = old[i] + gain * (output[i] - old[i]);
+        }
+    }
     
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    filterFadeRemaining -= length;
     
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    if (filters == DualMonoFilters::parallel)
+        fadingDesign = parallelDesign;
+}
+
+void ZooEQAudioProcessor::processFilters(DualMonoFilters filters, juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings,
+                                         FilterEngine engine, const ParallelDesign& design)
+{
+    switch (filters)
+    {
+        case DualMonoFilters::parallel:
+            processChannels(DualMonoFilters::parallel, leftParallel, rightParallel, buffer,
+                            [&design](ParallelFilter& filter, float* samples, int numSamples, int)
+                            {
+                                filter.process(design, samples, numSamples);
+                            });
+            break;
+            
+        case DualMonoFilters::stateVariable:
+            processChannels(DualMonoFilters::stateVariable, leftSvf, rightSvf, buffer,
+                            [&chainSettings](SvfCascade& filter, float* samples, int numSamples, int)
+                            {
+                                filter.process(chainSettings, samples, numSamples);
+                            });
+            break;
+            
+        case DualMonoFilters::cascade:
+        case DualMonoFilters::none:
+            //Fading out of the state variable filters, the cascade may be another engine
+            if (engine == FilterEngine::stateVariable)
+                engine = FilterEngine::recursive;
+            
+            updateFilters(chainSettings);
+            processChannels(DualMonoFilters::cascade, leftCascade, rightCascade, buffer,
+                            [this, engine](KernelCascade& filter, float* samples, int numSamples, int channel)
+                            {
+                                filter.process(channel == 0 ? leftChain : rightChain, samples, numSamples, engine);
+                            });
+            break;
+    }
+}
+
+void ZooEQAudioProcessor::resetFilters(DualMonoFilters filters)
+{
+    switch (filters)
+    {
+        case DualMonoFilters::cascade:       leftCascade.reset(); rightCascade.reset(); break;
+        case DualMonoFilters::parallel:      leftParallel.reset(); rightParallel.reset(); break;
+        case DualMonoFilters::stateVariable: leftSvf.reset(); rightSvf.reset(); break;
+        case DualMonoFilters::none:          break;
+    }
+}
+
+void ZooEQAudioProcessor::processMidSide(juce::AudioBuffer<float>& buffer, const ChainSettings& midSettings,
+                                         const ChainSettings& sideSettings, FilterEngine engine)
+{
+    const auto numSamples = buffer.getNumSamples();
+    auto* mid = buffer.getWritePointer(0);
+    auto* side = buffer.getWritePointer(1);
+    auto& kernels = getKernels();
+    
+    //The left filters run the mid and the right ones the side. A sub-block fits in cache,
+    //so the matrix passes around them cost next to nothing.
+    kernels.matrixMidSide(mid, side, numSamples, 0.5f);
+    
+    //The parallel topology has a single design, so mid/side always runs in series
+    if (engine == FilterEngine::stateVariable)
+    {
+        leftSvf.process(midSettings, mid, numSamples);
+        rightSvf.process(sideSettings, side, numSamples);
+    }
+    else
+    {
+        updateFilters(midSettings, sideSettings);
+        leftCascade.process(leftChain, mid, numSamples, engine);
+        rightCascade.process(rightChain, side, numSamples, engine);
+    }
+    
+    kernels.matrixMidSide(mid, side, numSamples, 1.0f);
+}
+
+template<typename FilterType, typename Process>
+void ZooEQAudioProcessor::processChannels(DualMonoFilters filters, FilterType& left, FilterType& right,
+                                          juce::AudioBuffer<float>& buffer, Process&& process)
+{
+    const auto numSamples = buffer.getNumSamples();
+    auto* leftSamples = buffer.getWritePointer(0);
+    auto* rightSamples = buffer.getWritePointer(1);
+    
+    if (dualMono != filters)
+        endDualMono();
+    
+    //Many stereo tracks are a mono source on both sides. memcmp is vectorised and stops at the
+    //first difference, so real stereo only pays for its first few samples. Only filters that
+    //are in the same state give the same output, which they stay in as long as the input matches.
+    const auto identical = std::memcmp(leftSamples, rightSamples, sizeof(float) * static_cast<size_t>(numSamples)) == 0;
+    
+    if (identical && (dualMono == filters || left.hasSameState(right)))
+    {
+        process(left, leftSamples, numSamples, 0);
+        juce::FloatVectorOperations::copy(rightSamples, leftSamples, numSamples);
+        dualMono = filters;
+        return;
+    }
+    
+    endDualMono();
+    process(left, leftSamples, numSamples, 0);
+    process(right, rightSamples, numSamples, 1);
+}
+
+void ZooEQAudioProcessor::endDualMono()
+{
+    //The right filters sat out while the left ones did the work for both, so they take over their state
+    switch (dualMono)
+    {
+        case DualMonoFilters::cascade:       rightCascade.copyStateFrom(leftCascade); break;
+        case DualMonoFilters::parallel:      rightParallel.copyStateFrom(leftParallel); break;
+        case DualMonoFilters::stateVariable: rightSvf.copyStateFrom(leftSvf); break;
+        case DualMonoFilters::none:          break;
+    }
+    
+    dualMono = DualMonoFilters::none;
+}
+
+void ZooEQAudioProcessor::processMorph(juce::AudioBuffer<float>& buffer, FilterEngine engine, int interval)
+{
+    const auto numSamples = buffer.getNumSamples();
+    const auto startAmount = morphAmount;
+    const auto targetAmount = apvts.getRawParameterValue("Morph")->load();
+    
+    //Redesigns once per control interval, gliding to the parameter's value over the block
+    jassert(interval <= morphBuffer.getNumSamples());
+    
+    for (int offset = 0; offset < numSamples; offset += interval)
+    {
+        const auto length = juce::jmin(interval, numSamples - offset);
+        morphAmount = startAmount + (targetAmount - startAmount) * static_cast<float>(offset + length) / static_cast<float>(numSamples);
+        
+        const auto morphed = morphChainSettings(playingMorphSnapshots, morphAmount);
+        const auto crossfade = morphed.needsCrossfade();
+        
+        auto* left = buffer.getWritePointer(0, offset);
+        auto* right = buffer.getWritePointer(1, offset);
+        auto* targetLeft = morphBuffer.getWritePointer(0);
+        auto* targetRight = morphBuffer.getWritePointer(1);
+        
+        if (crossfade)
+        {
+            juce::FloatVectorOperations::copy(targetLeft, left, length);
+            juce::FloatVectorOperations::copy(targetRight, right, length);
+        }
+        
+        if (engine == FilterEngine::stateVariable)
+        {
+            leftSvf.process(morphed.from, left, length);
+            rightSvf.process(morphed.from, right, length);
+            
+            if (crossfade)
+            {
+                morphTarget.leftSvf.process(morphed.to, targetLeft, length);
+                morphTarget.rightSvf.process(morphed.to, targetRight, length);
+            }
+        }
+        else
+        {
+            updateFilters(morphed.from);
+            leftCascade.process(leftChain, left, length, engine);
+            rightCascade.process(rightChain, right, length, engine);
+            
+            if (crossfade)
+            {
+                updateMonoChain(morphTarget.chain, morphed.to, getSampleRate());
+                morphTarget.leftCascade.process(morphTarget.chain, targetLeft, length, engine);
+                morphTarget.rightCascade.process(morphTarget.chain, targetRight, length, engine);
+            }
+        }
+        
+        //Both sides are the same EQ apart from the slopes, so they add up coherently
+        if (crossfade)
+        {
+            juce::FloatVectorOperations::multiply(left, 1.f - morphed.crossfade, length);
+            juce::FloatVectorOperations::multiply(right, 1.f - morphed.crossfade, length);
+            juce::FloatVectorOperations::addWithMultiply(left, targetLeft, morphed.crossfade, length);
+            juce::FloatVectorOperations::addWithMultiply(right, targetRight, morphed.crossfade, length);
+        }
+    }
 }
 
 //==============================================================================
@@ -212,9 +739,8 @@ void ZooEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // as intermediaries to make it easy to save and load complex data.
     
     //This command is to save your parameters when you quit the plugin
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
-    
+    //A fixed header and the packed parameter values, see StateFormat.h
+    writeBinaryState(apvts, morphSnapshots, destData);
 }
 
 void ZooEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -223,11 +749,21 @@ void ZooEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes
     // whose contents will have been created by the getStateInformation() call.
     
     //This command is to save your parameters when you quit the plugin
+    //The binary format applies straight to the parameters, processBlock() picks them up
+    if (readBinaryState(apvts, morphSnapshots, data, static_cast<size_t>(sizeInBytes)))
+    {
+        morphSnapshotFifo.push(morphSnapshots);
+        return;
+    }
+    
+    //Sessions saved before the binary format hold the whole ValueTree. Replacing it notifies
+    //the parameters, so processBlock() picks them up the same way; the filters are only
+    //ever designed on the audio thread.
     auto tree = juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes));
     if ( tree.isValid() )
     {
         apvts.replaceState(tree);
-        updateFilters();
+        clearMorphSnapshots();
     }
 }
 
@@ -249,99 +785,126 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               chainSettings.peakFreq,
-                                                               chainSettings.peakQuality,
-                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    ChainSettings settings;
+    
+    for (size_t i = 0; i < sideChainParameterIDs.size(); ++i)
+        applyParameterChange(settings, { static_cast<ChainParameter>(i), apvts.getRawParameterValue(sideChainParameterIDs[i])->load(), 0 });
+    
+    return settings;
 }
 
-void ZooEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+void ZooEQAudioProcessor::updatePeakFilter(MonoChain& chain, const ChainSettings& chainSettings)
 {
     //Read if filter is bypassed
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    chain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
     
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-}
-
-void updateCoefficients(Coefficients &old, const Coefficients &replacements)
-{
-    *old = *replacements;
+    auto peakCoefficients = makePeakCoefficients(chainSettings, getSampleRate());
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
 }
 
-void ZooEQAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings)
+void ZooEQAudioProcessor::updateLowCutFilters(MonoChain& chain, const ChainSettings &chainSettings)
 {
     //Read if filter is bypassed
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    chain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
     
     //Definition of the low cut filter coefficients
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    
-    //Set the LowCut Filter Coeffecients to the left chain
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    
-    //Set the LowCut Filter Coeffecients to the right chain
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    auto lowCutCoefficients = makeLowCutCoefficients(chainSettings, getSampleRate());
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
 }
 
-void ZooEQAudioProcessor::updateHighCutFilter(const ChainSettings &chainSettings)
+void ZooEQAudioProcessor::updateHighCutFilter(MonoChain& chain, const ChainSettings &chainSettings)
 {
     //Read if filter is bypassed
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    chain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
     
     //Definition of the high cut filter coefficients
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    auto highCutCoefficients = makeHighCutCoefficients(chainSettings, getSampleRate());
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+}
+
+void ZooEQAudioProcessor::updateFilters()
+{
+    updateFilters(getChainSettings(apvts));
+}
+
+void ZooEQAudioProcessor::updateFilters(const ChainSettings& chainSettings)
+{
+    updateFilters(chainSettings, chainSettings);
+}
+
+void ZooEQAudioProcessor::updateFilters(const ChainSettings& leftSettings, const ChainSettings& rightSettings)
+{
+    const auto redesignAll = designedSampleRate != getSampleRate();
+    updateChain(leftChain, designedSettings[0], leftSettings, redesignAll);
+    updateChain(rightChain, designedSettings[1], rightSettings, redesignAll);
+    designedSampleRate = getSampleRate();
+}
+
+void ZooEQAudioProcessor::updateChain(MonoChain& chain, ChainSettings& designed, const ChainSettings& chainSettings, bool redesignAll)
+{
+    //Automation usually moves one band at a time, so only the bands that changed are redesigned
+    if (redesignAll || chainSettings.lowCutFreq != designed.lowCutFreq || chainSettings.lowCutSlope != designed.lowCutSlope
+        || chainSettings.lowCutBypassed != designed.lowCutBypassed)
+        updateLowCutFilters(chain, chainSettings);
+    
+    if (redesignAll || chainSettings.peakFreq != designed.peakFreq || chainSettings.peakGainInDecibels != designed.peakGainInDecibels
+        || chainSettings.peakQuality != designed.peakQuality || chainSettings.peakBypassed != designed.peakBypassed)
+        updatePeakFilter(chain, chainSettings);
     
-    //Set the HighCut Filter Coeffecients to the left chain
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    if (redesignAll || chainSettings.highCutFreq != designed.highCutFreq || chainSettings.highCutSlope != designed.highCutSlope
+        || chainSettings.highCutBypassed != designed.highCutBypassed)
+        updateHighCutFilter(chain, chainSettings);
     
-    //Set the HighCut Filter Coeffecients to the right chain
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    designed = chainSettings;
 }
 
-void ZooEQAudioProcessor::updateFilters()
+bool ZooEQAudioProcessor::updateParallelDesign(const ChainSettings& chainSettings)
 {
-    auto chainSettigns = getChainSettings(apvts);
-    updateLowCutFilters(chainSettigns);
-    updatePeakFilter(chainSettigns);
-    updateHighCutFilter(chainSettigns);
+    //Offline there's no deadline, and waiting for the designer thread would make renders differ
+    if (isNonRealtime())
+    {
+        if (parallelDesign.settings != chainSettings || parallelDesign.sampleRate != getSampleRate())
+            parallelDesign = designParallelSections(chainSettings, getSampleRate());
+    }
+    else
+    {
+        parallelDesigner.requestDesign(chainSettings, getSampleRate());
+        parallelDesigner.pullLatestDesign(parallelDesign);
+    }
+    
+    //A design lags the settings by a few milliseconds, but one for another sample rate is just wrong
+    return parallelDesign.valid && parallelDesign.sampleRate == getSampleRate();
 }
 
-juce::AudioProcessorValueTreeState::ParameterLayout
-    ZooEQAudioProcessor::createParameterLayout() //Parameters of the plugin (Cut/Peak/Gain/Quality/Slope)
+//The bands of one domain, IDs in ChainParameter order, which is also the order they were first added in
+static void addChainParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout,
+                               const std::array<const char*, static_cast<size_t>(ChainParameter::count)>& ids)
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq",
-                                                           "LowCut Freq",
+    auto id = [&ids](ChainParameter parameter) { return ids[static_cast<size_t>(parameter)]; };
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(id(ChainParameter::lowCutFreq),
+                                                           id(ChainParameter::lowCutFreq),
                                                            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
                                                            20.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq",
-                                                           "HighCut Freq",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(id(ChainParameter::highCutFreq),
+                                                           id(ChainParameter::highCutFreq),
                                                            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
                                                            20000.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq",
-                                                           "Peak Freq",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(id(ChainParameter::peakFreq),
+                                                           id(ChainParameter::peakFreq),
                                                            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
                                                            750.f));
         
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain",
-                                                           "Peak Gain",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(id(ChainParameter::peakGain),
+                                                           id(ChainParameter::peakGain),
                                                            juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
                                                            0.0f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality",
-                                                           "Peak Quality",
+    layout.add(std::make_unique<juce::AudioParameterFloat>(id(ChainParameter::peakQuality),
+                                                           id(ChainParameter::peakQuality),
                                                            juce::NormalisableRange<float>(0.1f, 10.f, 0.5f, 1.f),
                                                            1.f));
 
@@ -353,13 +916,40 @@ juce::AudioProcessorValueTreeState::ParameterLayout
             stringArray.add(str);
         }
 
-        layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
-        layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(id(ChainParameter::lowCutSlope), id(ChainParameter::lowCutSlope), stringArray, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(id(ChainParameter::highCutSlope), id(ChainParameter::highCutSlope), stringArray, 0));
     
-    layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypassed", "LowCut Bypassed", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
-    layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(id(ChainParameter::lowCutBypassed), id(ChainParameter::lowCutBypassed), false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(id(ChainParameter::peakBypassed), id(ChainParameter::peakBypassed), false));
+    layout.add(std::make_unique<juce::AudioParameterBool>(id(ChainParameter::highCutBypassed), id(ChainParameter::highCutBypassed), false));
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout
+    ZooEQAudioProcessor::createParameterLayout() //Parameters of the plugin (Cut/Peak/Gain/Quality/Slope)
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    addChainParameters(layout, chainParameterIDs);
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyser Enable", "Analyser Enable", true));
+    
+    //New parameters go last, so the hosts' parameter indices of the others don't move
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Morph",
+                                                           "Morph",
+                                                           juce::NormalisableRange<float>(0.f, 1.f),
+                                                           0.f));
+    
+    //Inter-sample peak metering of the output, off by default for its CPU cost
+    layout.add(std::make_unique<juce::AudioParameterBool>("TruePeak Enable", "TruePeak Enable", false));
+    
+    //In mid/side mode the bands above filter the mid, and these the side
+    layout.add(std::make_unique<juce::AudioParameterBool>("MidSide Enable", "MidSide Enable", false));
+    addChainParameters(layout, sideChainParameterIDs);
+    
+    //Brickwall cuts in the frequency domain, the transition in octaves takes the place of the slope
+    layout.add(std::make_unique<juce::AudioParameterBool>("Spectral Cuts", "Spectral Cuts", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Spectral Transition",
+                                                           "Spectral Transition",
+                                                           juce::NormalisableRange<float>(0.02f, 2.f, 0.01f, 0.5f),
+                                                           0.17f));
  
     return layout;
 }
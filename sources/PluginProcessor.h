@@ -10,238 +10,31 @@
 
 #include <JuceHeader.h>
 #include <array>
-
-template<typename T>
-struct Fifo
-{
-    void prepare(int numChannels, int numSamples)
-    {
-        static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
-                      "prepare(numChannels, numSamples) should only be use when the fifo is holding std::AudioBuffer<float>");
-        
-        for (auto& buffer : buffers)
-        {
-            buffer.setSize(numChannels,
-                           numSamples,
-                           false,       //clear everything ?
-                           true,        //including the extra space ?
-                           true);       //avoid reallocation if you can ?
-            buffer.clear();
-        }
-    }
-    
-    void prepare(size_t numElements)
-    {
-        static_assert(std::is_same_v<T, std::vector<float>>,
-                      "prepare(numElements) should only be use when the fifo is holding std::vector<float>");
-        
-        for ( auto& buffer : buffers )
-        {
-            buffer.clear();
-            buffer.resize(numElements, 0);
-        }
-        
-    }
-    
-    bool push(const T& t)
-    {
-        auto write = fifo.write(1);
-        if(write.blockSize1 > 0)
-        {
-            buffers[static_cast<typename std::array<T, Capacity>::size_type>(write.startIndex1)] = t;
-            return true;
-        }
-        return false;
-    }
-    
-    bool pull(T& t)
-    {
-        auto read = fifo.read(1);
-        if(read.blockSize1 > 0)
-        {
-            t = buffers[static_cast<typename std::array<T, Capacity>::size_type>(read.startIndex1)];
-            return true;
-        }
-        return false;
-    }
-    
-    int getNumAvailableForReading() const
-    {
-        return fifo.getNumReady();
-    }
-    
-private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo {Capacity};
-};
-
-enum Channel
-{
-    Right, //Effectively 0
-    Left //Effectively 1
-};
-
-template<typename BlockType>
-struct SingleChannelSampleFifo
-{
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
-    {
-        prepared.set(false);
-    }
-    
-    void update(const BlockType& buffer)
-    {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
-        
-        for ( int i = 0; i < buffer.getNumSamples(); ++i )
-        {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
-    }
-    
-    void prepare(int bufferSize)
-    {
-        prepared.set(false);
-        size.set(bufferSize);
-        
-        bufferToFill.setSize(1,             //Channel
-                             bufferSize,    //Num Sample
-                             false,         //KeepExistingContent
-                             true,          //Clear extra space
-                             true);         //avoid reallocating
-        
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
-    }
-    
-    //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
-    //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
-private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
-    
-    void pushNextSampleIntoFifo(float sample)
-    {
-        if ( fifoIndex == bufferToFill.getNumSamples() )
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
-            
-            juce::ignoreUnused(ok);
-            
-            fifoIndex = 0;
-        }
-        
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
-    }
-};
-
-enum Slope
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-struct ChainSettings
-{
-    float peakFreq{0}, peakGainInDecibels{0}, peakQuality{0};
-    float lowCutFreq{0}, highCutFreq{0};
-    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
-    bool lowCutBypassed { false }, peakBypassed { false }, highCutBypassed { false };
-};
+#include <optional>
+#include "PresetBank.h"
+#include "dsp/Fifo.h"
+#include "dsp/FilterChain.h"
+#include "dsp/ParallelSections.h"
+#include "dsp/StateVariableFilter.h"
+#include "dsp/Morph.h"
+#include "dsp/CompareSlots.h"
+#include "dsp/LevelMeter.h"
+#include "dsp/TruePeakMeter.h"
+#include "dsp/LoudnessMeter.h"
+#include "dsp/Automation.h"
+#include "dsp/SpectralCuts.h"
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
-using Filter = juce::dsp::IIR::Filter<float>;
-
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-
-enum ChainPositions
-{
-    LowCut,
-    Peak,
-    HighCut
-};
-
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, CoefficientType& cutCoefficients)
-{
-    updateCoefficients(chain.template get<Index>().coefficients, cutCoefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
-
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& chain,
-                     const CoefficientType& coefficients,
-                     const Slope& slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-    
-    switch ( slope )
-    {
-        case Slope_48:
-        {
-            update<3>(chain, coefficients);
-        }
-        case Slope_36:
-        {
-            update<2>(chain, coefficients);
-        }
-        case Slope_24:
-        {
-            update<1>(chain, coefficients);
-        }
-        case Slope_12:
-        {
-            update<0>(chain, coefficients);
-        }
-    }
-}
-
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                       sampleRate,
-                                                                                       2 *(chainSettings.lowCutSlope + 1));
-    //For the order parameter, it is changing the slope choice (0/1/2/3) in filter order (2/4/6/8)
-}
-
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                      sampleRate,
-                                                                                      2 *(chainSettings.highCutSlope + 1));
-    //For the order parameter, it is changing the slope choice (0/1/2/3) in filter order (2/4/6/8)
-}
+/** The side's bands, which only play in mid/side mode */
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
 //==============================================================================
 /**
 */
-class ZooEQAudioProcessor  : public juce::AudioProcessor
+class ZooEQAudioProcessor  : public juce::AudioProcessor,
+                             private juce::AudioProcessorParameter::Listener,
+                             private juce::Timer
 {
 public:
     //==============================================================================
@@ -287,13 +80,180 @@ public:
     using BlockType = juce::AudioBuffer<float>;
     SingleChannelSampleFifo<BlockType> leftChannelFifo { Channel::Left };
     SingleChannelSampleFifo<BlockType> rightChannelFifo { Channel::Right };
+    
+    //Before and after the filters, measured in processBlock() and read by the editor's meters
+    LevelMeter inputMeter, outputMeter;
+    TruePeakMeter truePeakMeter;
+    
+    //The output is measured before the loudness compensation, which matches it to the input
+    LoudnessMeter inputLoudness, outputLoudness;
+    
+    /** Overrides the CPU check for the filter kernels from the next prepareToPlay(), for testing */
+    void forceInstructionSet(std::optional<InstructionSet> instructionSet) { forcedInstructionSet = instructionSet; }
+    const DspKernels& getKernels() const { return leftCascade.getKernels(); }
+    
+    /** Chooses the filter engine used while playing in real time, or while rendering offline */
+    void setFilterEngine(bool nonRealtime, FilterEngine engine) { (nonRealtime ? offlineEngine : realtimeEngine) = engine; }
+    FilterEngine getFilterEngine(bool nonRealtime) const { return nonRealtime ? offlineEngine : realtimeEngine; }
+    
+    /** Series runs the chain as it is, parallel its partial fraction expansion when that is accurate enough */
+    void setFilterTopology(FilterTopology newTopology) { topology = newTopology; }
+    FilterTopology getFilterTopology() const { return topology; }
+    
+    /** The design the parallel topology is currently playing, for tests and benchmarks */
+    const ParallelDesign& getParallelDesign() const { return parallelDesign; }
+    
+    /** Replaces the programs with the presets of a bank file, returns false if it isn't one */
+    bool loadPresetBank(const juce::File& file);
+    
+    /**
+        Message thread: sets morph snapshot A (slot 0) or B (slot 1). Once both are set the
+        Morph parameter moves the EQ between them and the other parameters are ignored.
+     */
+    void setMorphSnapshot(int slot, const ChainSettings& settings);
+    void captureMorphSnapshot(int slot) { setMorphSnapshot(slot, getChainSettings(apvts)); }
+    void clearMorphSnapshots();
+    const MorphSnapshots& getMorphSnapshots() const { return morphSnapshots; }
+    
+    /**
+        Message thread: stores the current settings in compare slot 0 to 3 (A to D), designed
+        for the current sample rate, and plays a slot instead of the parameters, or
+        CompareSlots::live to hear the parameters again. Neither touches the parameters.
+     */
+    void storeCompareSlot(int index) { compareSlots.store(index, getChainSettings(apvts)); }
+    void selectCompareSlot(int index) { compareSlots.select(index); }
+    int getSelectedCompareSlot() const { return compareSlots.getSelected(); }
+    
+    /**
+        Matches the short-term loudness of the output to the input's, so the compare slots
+        and the live settings are heard at the same loudness rather than the louder one
+        sounding better. Off by default.
+     */
+    void setLoudnessCompensation(bool shouldCompensate) { loudnessCompensation = shouldCompensate; }
+    bool isLoudnessCompensated() const { return loudnessCompensation; }
+    
+    /** The most processBlock() handles at once: longer host blocks are split, shorter ones run as they are */
+    static constexpr int subBlockSize = 256;
+    
+    /**
+        What processBlock() spends its time on besides the filters. Playing live it stays lean
+        and predictable. Rendering offline nobody watches the meters and there is no deadline,
+        so the CPU goes to quality instead.
+     */
+    struct ProcessingProfile
+    {
+        bool analyserTap;       //Fills the editor's analyser and goniometer
+        bool levelMeters;       //Peak, RMS and true-peak meters, the loudness meters always run
+        int maxAutomationSplits;
+        int morphInterval;      //Samples between two redesigns while morphing
+    };
+    
+    static constexpr ProcessingProfile realtimeProfile { true, true, AutomationQueue::maxSplitsPerBlock, morphControlInterval };
+    static constexpr ProcessingProfile offlineProfile { false, false, AutomationQueue::maxChangesPerBlock, 16 };
+    static const ProcessingProfile& getProcessingProfile(bool nonRealtime) { return nonRealtime ? offlineProfile : realtimeProfile; }
 private:
     MonoChain leftChain, rightChain;
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilter(const ChainSettings& chainSettings);
+    PresetBank presetBank;
+    int currentProgram = 0;
+    
+    //The message thread edits morphSnapshots, the audio thread plays its own copy
+    MorphSnapshots morphSnapshots, playingMorphSnapshots;
+    Fifo<MorphSnapshots> morphSnapshotFifo;
+    float morphAmount = 0;
+    
+    //What the morph crossfades to when the snapshots' slopes differ, processed into morphBuffer
+    struct MorphTarget
+    {
+        MonoChain chain;
+        KernelCascade leftCascade, rightCascade;
+        SvfCascade leftSvf, rightSvf;
+    } morphTarget;
+    juce::AudioBuffer<float> morphBuffer;
+    
+    CompareSlots compareSlots;
+    
+    std::atomic<bool> loudnessCompensation { false };
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> compensationGain;
+    void applyLoudnessCompensation(juce::AudioBuffer<float>& buffer);
+    KernelCascade leftCascade, rightCascade;
+    SvfCascade leftSvf, rightSvf;
+    std::optional<InstructionSet> forcedInstructionSet;
+    std::atomic<FilterEngine> realtimeEngine { FilterEngine::recursive }, offlineEngine { FilterEngine::recursive };
+    
+    std::atomic<FilterTopology> topology { FilterTopology::series };
+    ParallelFilter leftParallel, rightParallel;
+    ParallelDesign parallelDesign;
+    ParallelDesigner parallelDesigner;
+    
+    void updatePeakFilter(MonoChain& chain, const ChainSettings& chainSettings);
+    void updateLowCutFilters(MonoChain& chain, const ChainSettings& chainSettings);
+    void updateHighCutFilter(MonoChain& chain, const ChainSettings& chainSettings);
     void updateFilters();
+    void updateFilters(const ChainSettings& chainSettings);
+    void updateFilters(const ChainSettings& leftSettings, const ChainSettings& rightSettings);
+    void updateChain(MonoChain& chain, ChainSettings& designed, const ChainSettings& chainSettings, bool redesignAll);
+    bool updateParallelDesign(const ChainSettings& chainSettings);
+    void processMorph(juce::AudioBuffer<float>& buffer, FilterEngine engine, int interval);
+    void processLive(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, FilterEngine engine,
+                     const ProcessingProfile& profile);
+    void processSubBlock(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, FilterEngine engine,
+                         const ProcessingProfile& profile);
+    
+    //Which pair of filters is running dual mono: the left one filters both channels, the right one is stale
+    enum class DualMonoFilters
+    {
+        none,
+        cascade,
+        parallel,
+        stateVariable
+    };
+    DualMonoFilters dualMono = DualMonoFilters::none;
+    
+    //The filters that played the last live sub-block. Switching to others crossfades from them for
+    //CompareSlots::fadeTime, since neither form's state carries over to the other. They fade out
+    //with the parallel design they last played, in case the new one is invalid.
+    DualMonoFilters liveFilters = DualMonoFilters::none, fadingFilters = DualMonoFilters::none;
+    ParallelDesign fadingDesign;
+    int filterFadeLength = 0, filterFadeRemaining = 0;
+    juce::AudioBuffer<float> filterFadeBuffer;
+    
+    void processFilters(DualMonoFilters filters, juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings,
+                        FilterEngine engine, const ParallelDesign& design);
+    void resetFilters(DualMonoFilters filters);
+    
+    template<typename FilterType, typename Process>
+    void processChannels(DualMonoFilters filters, FilterType& left, FilterType& right,
+                         juce::AudioBuffer<float>& buffer, Process&& process);
+    void endDualMono();
+    
+    void processMidSide(juce::AudioBuffer<float>& buffer, const ChainSettings& midSettings,
+                        const ChainSettings& sideSettings, FilterEngine engine);
+    
+    //Replaces the IIR cuts while "Spectral Cuts" is on, and adds its latency
+    SpectralCuts spectralCuts;
+    bool spectralCutsActive = false;
+    std::atomic<int> spectralCutsLatency { 0 };
+    void updateSpectralCuts();
+    int getSpectralCutsLatency() const;
+    
+    //Reporting the latency calls the host back under a lock, so it is done from the message thread
+    void timerCallback() override;
+    
+    //The settings the chains were last designed for, so updateFilters() only redesigns what changed
+    std::array<ChainSettings, 2> designedSettings;
+    double designedSampleRate = 0;
+    
+    //The chain parameters reach the audio thread through the queue, with the offset they are due at
+    std::array<juce::RangedAudioParameter*, static_cast<size_t>(ChainParameter::count)> chainParameters {};
+    AutomationQueue automation;
+    ChainSettings automatedSettings;
+    std::atomic<bool> automationResync { true };
+    std::atomic<juce::Thread::ThreadID> audioThreadId { nullptr };
+    std::atomic<double> blockStartTime { 0 };
+    
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
     
     juce::dsp::Oscillator<float> osc;
     //==============================================================================
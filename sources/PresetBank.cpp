@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    A read-only, memory-mapped bank of presets.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+static constexpr juce::uint32 presetBankMagic = 0x6251456d;
+static constexpr juce::uint16 presetBankVersion = 1;
+static constexpr size_t headerSize = 12;
+static constexpr size_t indexEntrySize = 8;
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("myEQ")
+               .getChildFile("Presets.myeqbank");
+}
+
+bool PresetBank::write(const juce::File& file, const std::vector<Preset>& presets)
+{
+    juce::MemoryOutputStream index, records;
+    auto recordsStart = headerSize + presets.size() * indexEntrySize;
+    
+    for (auto& preset : presets)
+    {
+        auto name = preset.name.toUTF8();
+        auto nameLength = name.sizeInBytes() - 1;
+        
+        if (nameLength > 0xffff || preset.state.getSize() > 0xffff)
+            return false;
+        
+        index.writeInt(static_cast<int>(recordsStart + records.getDataSize()));
+        index.writeShort(static_cast<short>(nameLength));
+        index.writeShort(static_cast<short>(preset.state.getSize()));
+        
+        records.write(name.getAddress(), nameLength);
+        records.write(preset.state.getData(), preset.state.getSize());
+    }
+    
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+    
+    juce::TemporaryFile temporary(file);
+    
+    {
+        juce::FileOutputStream out(temporary.getFile());
+        if (! out.openedOk())
+            return false;
+        
+        out.writeInt(static_cast<int>(presetBankMagic));
+        out.writeShort(static_cast<short>(presetBankVersion));
+        out.writeShort(0);
+        out.writeInt(static_cast<int>(presets.size()));
+        out.write(index.getData(), index.getDataSize());
+        out.write(records.getData(), records.getDataSize());
+        out.flush();
+        
+        if (out.getStatus().failed())
+            return false;
+    }
+    
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+bool PresetBank::open(const juce::File& file)
+{
+    close();
+    
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* bytes = static_cast<const char*>(mapped->getData());
+    auto size = mapped->getSize();
+    
+    if (bytes == nullptr || size < headerSize
+        || juce::ByteOrder::littleEndianInt(bytes) != presetBankMagic
+        || juce::ByteOrder::littleEndianShort(bytes + 4) != presetBankVersion)
+        return false;
+    
+    auto count = static_cast<size_t>(juce::ByteOrder::littleEndianInt(bytes + 8));
+    
+    //Only the index has to fit here, records are checked when they are used
+    if (count > (size - headerSize) / indexEntrySize)
+        return false;
+    
+    mappedFile = std::move(mapped);
+    data = bytes;
+    dataSize = size;
+    numPresets = static_cast<int>(count);
+    return true;
+}
+
+void PresetBank::close()
+{
+    mappedFile.reset();
+    data = nullptr;
+    dataSize = 0;
+    numPresets = 0;
+}
+
+bool PresetBank::getRecord(int index, Record& record) const
+{
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return false;
+    
+    auto* entry = data + headerSize + static_cast<size_t>(index) * indexEntrySize;
+    auto offset = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry));
+    auto nameLength = static_cast<size_t>(juce::ByteOrder::littleEndianShort(entry + 4));
+    auto stateSize = static_cast<size_t>(juce::ByteOrder::littleEndianShort(entry + 6));
+    
+    if (offset > dataSize || nameLength + stateSize > dataSize - offset)
+        return false;
+    
+    record = { data + offset, nameLength, data + offset + nameLength, stateSize };
+    return true;
+}
+
+juce::String PresetBank::getName(int index) const
+{
+    Record record;
+    if (! getRecord(index, record))
+        return {};
+    
+    return juce::String::fromUTF8(record.name, static_cast<int>(record.nameLength));
+}
+
+bool PresetBank::getState(int index, const void*& state, size_t& stateSize) const
+{
+    Record record;
+    if (! getRecord(index, record))
+        return false;
+    
+    state = record.state;
+    stateSize = record.stateSize;
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    A read-only, memory-mapped bank of presets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/**
+    Thousands of presets in one file, mapped rather than read, so opening a bank costs the
+    same whatever its size and looking up a preset only touches its own index entry and record.
+
+        header  uint32 presetBankMagic ("mEQb"), uint16 version, uint16 reserved, uint32 number of presets
+        index   per preset: uint32 record offset, uint16 name length, uint16 state size
+        records per preset: the UTF-8 name, then its state in the binary state format
+
+    All little-endian. The states are exactly what getStateInformation() writes, see StateFormat.h.
+ */
+class PresetBank
+{
+public:
+    struct Preset
+    {
+        juce::String name;
+        juce::MemoryBlock state;
+    };
+    
+    /** Where the plugin looks for its bank */
+    static juce::File getDefaultFile();
+    
+    /** Writes a bank, replacing the file only once it is complete */
+    static bool write(const juce::File& file, const std::vector<Preset>& presets);
+    
+    /** Maps a bank file, returns false (leaving the bank empty) if it isn't one */
+    bool open(const juce::File& file);
+    void close();
+    
+    int getNumPresets() const { return numPresets; }
+    
+    /** Empty for an index outside the bank */
+    juce::String getName(int index) const;
+    
+    /** Points into the mapped file, valid until the bank is closed; false for an index outside the bank */
+    bool getState(int index, const void*& state, size_t& stateSize) const;
+    
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const char* data = nullptr;
+    size_t dataSize = 0;
+    int numPresets = 0;
+    
+    struct Record
+    {
+        const char* name;
+        size_t nameLength;
+        const char* state;
+        size_t stateSize;
+    };
+    
+    bool getRecord(int index, Record& record) const;
+};
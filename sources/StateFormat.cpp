@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+    The compact binary layout of the plugin state.
+
+  ==============================================================================
+*/
+
+#include "StateFormat.h"
+
+//Never edit a released list, add a new version with its own list instead
+static constexpr const char* stateParameterIDsV1[]
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyser Enable"
+};
+
+static constexpr const char* stateParameterIDsV2[]
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyser Enable",
+    "Morph"
+};
+
+static constexpr const char* stateParameterIDsV3[]
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyser Enable",
+    "Morph",
+    "TruePeak Enable"
+};
+
+static constexpr const char* stateParameterIDsV4[]
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyser Enable",
+    "Morph",
+    "TruePeak Enable",
+    "MidSide Enable",
+    "Side LowCut Freq",
+    "Side HighCut Freq",
+    "Side Peak Freq",
+    "Side Peak Gain",
+    "Side Peak Quality",
+    "Side LowCut Slope",
+    "Side HighCut Slope",
+    "Side LowCut Bypassed",
+    "Side Peak Bypassed",
+    "Side HighCut Bypassed"
+};
+
+static constexpr const char* stateParameterIDsV5[]
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyser Enable",
+    "Morph",
+    "TruePeak Enable",
+    "MidSide Enable",
+    "Side LowCut Freq",
+    "Side HighCut Freq",
+    "Side Peak Freq",
+    "Side Peak Gain",
+    "Side Peak Quality",
+    "Side LowCut Slope",
+    "Side HighCut Slope",
+    "Side LowCut Bypassed",
+    "Side Peak Bypassed",
+    "Side HighCut Bypassed",
+    "Spectral Cuts",
+    "Spectral Transition"
+};
+
+static constexpr size_t valuesPerSnapshot = 10;
+static constexpr size_t snapshotsSize = sizeof(juce::uint32) + 2 * valuesPerSnapshot * sizeof(float);
+
+juce::Span<const char* const> getStateParameterIDs(int version)
+{
+    switch (version)
+    {
+        case 1: return stateParameterIDsV1;
+        case 2: return stateParameterIDsV2;
+        case 3: return stateParameterIDsV3;
+        case 4: return stateParameterIDsV4;
+        case 5: return stateParameterIDsV5;
+        default: return {};
+    }
+}
+
+static void writeFloat(float value, char*& destination)
+{
+    juce::uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    juce::ByteOrder::writeLittleEndianInt(bits, destination);
+    destination += sizeof(float);
+}
+
+static float readFloat(const char*& source)
+{
+    float value;
+    auto bits = juce::ByteOrder::littleEndianInt(source);
+    std::memcpy(&value, &bits, sizeof(value));
+    source += sizeof(float);
+    return value;
+}
+
+static void writeSnapshot(const ChainSettings& settings, char*& destination)
+{
+    for (auto value : { settings.peakFreq, settings.peakGainInDecibels, settings.peakQuality,
+                        settings.lowCutFreq, settings.highCutFreq,
+                        static_cast<float>(settings.lowCutSlope), static_cast<float>(settings.highCutSlope),
+                        settings.lowCutBypassed ? 1.f : 0.f, settings.peakBypassed ? 1.f : 0.f, settings.highCutBypassed ? 1.f : 0.f })
+        writeFloat(value, destination);
+}
+
+static ChainSettings readSnapshot(const char*& source)
+{
+    auto toSlope = [](float value) { return static_cast<Slope>(juce::jlimit(0, 3, juce::roundToInt(value))); };
+    
+    ChainSettings settings;
+    settings.peakFreq = readFloat(source);
+    settings.peakGainInDecibels = readFloat(source);
+    settings.peakQuality = readFloat(source);
+    settings.lowCutFreq = readFloat(source);
+    settings.highCutFreq = readFloat(source);
+    settings.lowCutSlope = toSlope(readFloat(source));
+    settings.highCutSlope = toSlope(readFloat(source));
+    settings.lowCutBypassed = readFloat(source) > 0.5f;
+    settings.peakBypassed = readFloat(source) > 0.5f;
+    settings.highCutBypassed = readFloat(source) > 0.5f;
+    return settings;
+}
+
+void writeBinaryState(juce::AudioProcessorValueTreeState& apvts, const MorphSnapshots& snapshots,
+                      juce::MemoryBlock& destData)
+{
+    const auto ids = getStateParameterIDs(binaryStateVersion);
+    
+    destData.setSize(binaryStateHeaderSize + ids.size() * sizeof(float) + snapshotsSize);
+    auto* bytes = static_cast<char*>(destData.getData());
+    
+    juce::ByteOrder::writeLittleEndianInt(binaryStateMagic, bytes);
+    juce::ByteOrder::writeLittleEndianShort(static_cast<juce::uint16>(binaryStateVersion), bytes + 4);
+    juce::ByteOrder::writeLittleEndianShort(static_cast<juce::uint16>(ids.size()), bytes + 6);
+    
+    auto* values = bytes + binaryStateHeaderSize;
+    
+    for (auto* id : ids)
+    {
+        auto* value = apvts.getRawParameterValue(id);
+        jassert(value != nullptr);
+        writeFloat(value->load(), values);
+    }
+    
+    juce::ByteOrder::writeLittleEndianInt((snapshots.hasA ? 1u : 0u) | (snapshots.hasB ? 2u : 0u), values);
+    values += sizeof(juce::uint32);
+    writeSnapshot(snapshots.a, values);
+    writeSnapshot(snapshots.b, values);
+}
+
+bool isBinaryState(const void* data, size_t sizeInBytes)
+{
+    return sizeInBytes >= binaryStateHeaderSize && juce::ByteOrder::littleEndianInt(data) == binaryStateMagic;
+}
+
+bool readBinaryState(juce::AudioProcessorValueTreeState& apvts, MorphSnapshots& snapshots,
+                     const void* data, size_t sizeInBytes)
+{
+    if (! isBinaryState(data, sizeInBytes))
+        return false;
+    
+    auto* bytes = static_cast<const char*>(data);
+    const auto version = juce::ByteOrder::littleEndianShort(bytes + 4);
+    const size_t numParameters = juce::ByteOrder::littleEndianShort(bytes + 6);
+    const auto ids = getStateParameterIDs(version);
+    
+    const auto hasSnapshots = version >= 2;
+    const auto expectedSize = binaryStateHeaderSize + numParameters * sizeof(float) + (hasSnapshots ? snapshotsSize : 0);
+    
+    if (ids.empty() || numParameters != ids.size() || sizeInBytes < expectedSize)
+        return false;
+    
+    //Parameters an older version didn't save go back to their defaults, like in a fresh instance
+    if (version != binaryStateVersion)
+        for (auto* parameter : apvts.processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                ranged->setValueNotifyingHost(ranged->getDefaultValue());
+    
+    auto* values = bytes + binaryStateHeaderSize;
+    
+    for (auto* id : ids)
+    {
+        auto plain = readFloat(values);
+        
+        //A parameter that has since been removed
+        auto* parameter = apvts.getParameter(id);
+        if (parameter == nullptr)
+            continue;
+        
+        //Only what actually changes notifies the host and the attachments
+        auto normalised = parameter->convertTo0to1(plain);
+        if (parameter->getValue() != normalised)
+            parameter->setValueNotifyingHost(normalised);
+    }
+    
+    snapshots = {};
+    
+    if (hasSnapshots)
+    {
+        auto flags = juce::ByteOrder::littleEndianInt(values);
+        values += sizeof(juce::uint32);
+        snapshots.a = readSnapshot(values);
+        snapshots.b = readSnapshot(values);
+        snapshots.hasA = (flags & 1) != 0;
+        snapshots.hasB = (flags & 2) != 0;
+    }
+    
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    The compact binary layout of the plugin state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "dsp/Morph.h"
+
+/*
+    The state is a fixed 8 byte header followed by one little-endian float per parameter:
+
+        uint32  binaryStateMagic ("myEQ")
+        uint16  version
+        uint16  number of parameters
+        float   plain (not normalised) value of each parameter, in that version's order
+
+    From version 2 on, the morph snapshots follow the parameters:
+
+        uint32  bit 0 set if snapshot A is, bit 1 for B
+        float   A's ChainSettings, 10 values in declaration order
+        float   B's ChainSettings
+
+    Plain values survive range changes between versions, and every version keeps its list of
+    parameter IDs, so an older state is migrated by matching IDs: parameters it doesn't have
+    keep their defaults. New parameters are only ever added to a new version's list.
+ */
+static constexpr juce::uint32 binaryStateMagic = 0x5145796d;
+static constexpr int binaryStateVersion = 5;
+static constexpr size_t binaryStateHeaderSize = 8;
+
+/** The parameter IDs stored by a version, empty if the version is unknown */
+juce::Span<const char* const> getStateParameterIDs(int version);
+
+void writeBinaryState(juce::AudioProcessorValueTreeState& apvts, const MorphSnapshots& snapshots,
+                      juce::MemoryBlock& destData);
+
+bool isBinaryState(const void* data, size_t sizeInBytes);
+
+/**
+    Applies a binary state straight to the parameters, without going through a ValueTree.
+    Returns false, changing nothing, if the data isn't in this format (like the ValueTree
+    the plugin used to save) or is from a newer version. States from before the morph
+    snapshots clear them.
+ */
+bool readBinaryState(juce::AudioProcessorValueTreeState& apvts, MorphSnapshots& snapshots,
+                     const void* data, size_t sizeInBytes);
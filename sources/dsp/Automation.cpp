@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    Sample-accurate automation of the chain parameters.
+
+  ==============================================================================
+*/
+
+#include "Automation.h"
+
+const std::array<const char*, static_cast<size_t>(ChainParameter::count)> chainParameterIDs
+{
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed"
+};
+
+const std::array<const char*, static_cast<size_t>(ChainParameter::count)> sideChainParameterIDs
+{
+    "Side LowCut Freq",
+    "Side HighCut Freq",
+    "Side Peak Freq",
+    "Side Peak Gain",
+    "Side Peak Quality",
+    "Side LowCut Slope",
+    "Side HighCut Slope",
+    "Side LowCut Bypassed",
+    "Side Peak Bypassed",
+    "Side HighCut Bypassed"
+};
+
+void applyParameterChange(ChainSettings& settings, const ParameterChange& change)
+{
+    //The same conversions as getChainSettings()
+    switch (change.parameter)
+    {
+        case ChainParameter::lowCutFreq:      settings.lowCutFreq = change.value; break;
+        case ChainParameter::highCutFreq:     settings.highCutFreq = change.value; break;
+        case ChainParameter::peakFreq:        settings.peakFreq = change.value; break;
+        case ChainParameter::peakGain:        settings.peakGainInDecibels = change.value; break;
+        case ChainParameter::peakQuality:     settings.peakQuality = change.value; break;
+        case ChainParameter::lowCutSlope:     settings.lowCutSlope = static_cast<Slope>(change.value); break;
+        case ChainParameter::highCutSlope:    settings.highCutSlope = static_cast<Slope>(change.value); break;
+        case ChainParameter::lowCutBypassed:  settings.lowCutBypassed = change.value > 0.5f; break;
+        case ChainParameter::peakBypassed:    settings.peakBypassed = change.value > 0.5f; break;
+        case ChainParameter::highCutBypassed: settings.highCutBypassed = change.value > 0.5f; break;
+        case ChainParameter::count:           break;
+    }
+}
+
+bool AutomationQueue::push(const ParameterChange& change, bool fromAudioThread)
+{
+    if (fromAudioThread)
+        return audioThreadFifo.push(change);
+    
+    const juce::SpinLock::ScopedLockType lock(otherThreadsLock);
+    return otherThreadsFifo.push(change);
+}
+
+void AutomationQueue::beginBlock(int numSamples, int maxSplits)
+{
+    numChanges = 0;
+    nextChange = 0;
+    numSplits = 0;
+    splitsAllowed = maxSplits;
+    
+    //Inserted in order of their offsets as they arrive. Unlike std::stable_sort this never asks
+    //for a temporary buffer, and a later change only goes past those due after it, so two
+    //changes of one parameter at the same offset keep their order.
+    ParameterChange change;
+    while (numChanges < maxChangesPerBlock && (audioThreadFifo.pull(change) || otherThreadsFifo.pull(change)))
+    {
+        change.offset = juce::jlimit(0, juce::jmax(0, numSamples - 1), change.offset);
+        
+        auto position = numChanges++;
+        for (; position > 0 && changes[static_cast<size_t>(position - 1)].offset > change.offset; --position)
+            changes[static_cast<size_t>(position)] = changes[static_cast<size_t>(position - 1)];
+        
+        changes[static_cast<size_t>(position)] = change;
+    }
+}
+
+int AutomationQueue::advance(ChainSettings& settings, int offset, int maxLength)
+{
+    while (nextChange < numChanges && changes[static_cast<size_t>(nextChange)].offset <= offset)
+        applyParameterChange(settings, changes[static_cast<size_t>(nextChange++)]);
+    
+    auto end = offset + maxLength;
+    
+    if (nextChange < numChanges && numSplits < splitsAllowed)
+    {
+        const auto due = changes[static_cast<size_t>(nextChange)].offset;
+        if (due < end)
+        {
+            end = due;
+            ++numSplits;
+        }
+    }
+    
+    return end;
+}
+
+void AutomationQueue::endBlock(ChainSettings& settings)
+{
+    while (nextChange < numChanges)
+        applyParameterChange(settings, changes[static_cast<size_t>(nextChange++)]);
+}
+
+void AutomationQueue::clear()
+{
+    ParameterChange change;
+    while (audioThreadFifo.pull(change) || otherThreadsFifo.pull(change))
+        ;
+    
+    numChanges = 0;
+    nextChange = 0;
+}
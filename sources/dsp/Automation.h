@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    Sample-accurate automation of the chain parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include "FilterChain.h"
+#include "Fifo.h"
+
+/** The parameters that make up ChainSettings */
+enum class ChainParameter
+{
+    lowCutFreq,
+    highCutFreq,
+    peakFreq,
+    peakGain,
+    peakQuality,
+    lowCutSlope,
+    highCutSlope,
+    lowCutBypassed,
+    peakBypassed,
+    highCutBypassed,
+    count
+};
+
+/** The APVTS IDs of the ChainParameter values, in the same order */
+extern const std::array<const char*, static_cast<size_t>(ChainParameter::count)> chainParameterIDs;
+
+/** The same for the side's bands in mid/side mode, where the ones above are the mid's */
+extern const std::array<const char*, static_cast<size_t>(ChainParameter::count)> sideChainParameterIDs;
+
+/** A new plain (not normalised) value, due offset samples into the next block */
+struct ParameterChange
+{
+    ChainParameter parameter = ChainParameter::peakFreq;
+    float value = 0;
+    int offset = 0;
+};
+
+void applyParameterChange(ChainSettings& settings, const ParameterChange& change);
+
+/**
+    Hands parameter changes to the audio thread with the offset they are due at, and
+    tells processBlock() where to split the block for them. At most maxSplitsPerBlock
+    splits are made, so a burst of changes can't blow up the cost of a block: the ones
+    beyond that wait for the next boundary processBlock() would have split at anyway.
+
+    The fifos take one writer each, and changes come from the host's audio thread, the
+    message thread and whichever threads hosts automate from. The audio thread gets a fifo
+    of its own so it never waits, the others share one and take turns writing to it.
+ */
+class AutomationQueue
+{
+public:
+    static constexpr int maxSplitsPerBlock = 8;
+    static constexpr int maxChangesPerBlock = 32;
+    
+    /**
+        Any thread, saying whether it is the one processBlock() runs on: returns false if the
+        queue is full and the change was dropped
+     */
+    bool push(const ParameterChange& change, bool fromAudioThread);
+    
+    /** Audio thread: takes the changes queued since the last block, in order of their offsets */
+    void beginBlock(int numSamples, int maxSplits = maxSplitsPerBlock);
+    
+    /**
+        Audio thread: applies the changes due at offset to settings, and returns where the
+        part of the block starting there ends: at most maxLength later, or the next change
+     */
+    int advance(ChainSettings& settings, int offset, int maxLength);
+    
+    /** Audio thread: applies what advance() didn't get to, once the block is done */
+    void endBlock(ChainSettings& settings);
+    
+    /** Audio thread: throws the queued changes away, when the settings are read afresh */
+    void clear();
+    
+private:
+    Fifo<ParameterChange> audioThreadFifo, otherThreadsFifo;
+    juce::SpinLock otherThreadsLock;
+    std::array<ParameterChange, maxChangesPerBlock> changes;
+    int numChanges = 0, nextChange = 0, numSplits = 0, splitsAllowed = maxSplitsPerBlock;
+};
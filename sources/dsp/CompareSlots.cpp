@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    A/B/C/D compare slots, designed up front and switched with a crossfade.
+
+  ==============================================================================
+*/
+
+#include "CompareSlots.h"
+
+CompareSlot makeCompareSlot(const ChainSettings& chainSettings, double sampleRate)
+{
+    CompareSlot slot;
+    slot.settings = chainSettings;
+    slot.numSections = makeCascadeSections(chainSettings, sampleRate, slot.sections);
+    slot.sampleRate = sampleRate;
+    slot.stored = true;
+    return slot;
+}
+
+//==============================================================================
+void CompareSlots::prepare(double sampleRate)
+{
+    preparedSampleRate = sampleRate;
+    
+    //Nothing plays while preparing, so both sides can be written directly
+    for (size_t i = 0; i < storedSlots.size(); ++i)
+    {
+        if (storedSlots[i].stored)
+            storedSlots[i] = makeCompareSlot(storedSlots[i].settings, sampleRate);
+        
+        playingSlots[i] = storedSlots[i];
+        states[i] = {};
+    }
+    
+    SlotUpdate pending;
+    while (slotUpdates.pull(pending))
+        ;
+    
+    fadeLength = juce::jmax(1, juce::roundToInt(fadeTime * sampleRate));
+    fadeRemaining = 0;
+    fadeBuffer.setSize(2, 256);
+    
+    const auto initial = selected.load();
+    current = previous = initial != live && playingSlots[static_cast<size_t>(initial)].stored ? initial : live;
+}
+
+void CompareSlots::store(int index, const ChainSettings& chainSettings)
+{
+    jassert(index >= 0 && index < numSlots);
+    
+    auto& slot = storedSlots[static_cast<size_t>(index)];
+    slot = makeCompareSlot(chainSettings, preparedSampleRate);
+    slotUpdates.push({ index, slot });
+}
+
+void CompareSlots::select(int index)
+{
+    jassert(index >= live && index < numSlots);
+    selected = index;
+}
+
+void CompareSlots::update()
+{
+    SlotUpdate pending;
+    while (slotUpdates.pull(pending))
+    {
+        //New sections start from silence rather than another design's state
+        playingSlots[static_cast<size_t>(pending.index)] = pending.slot;
+        states[static_cast<size_t>(pending.index)] = {};
+    }
+    
+    auto next = selected.load();
+    if (next != live && ! playingSlots[static_cast<size_t>(next)].stored)
+        next = live;
+    
+    if (next != current)
+    {
+        //Switching again mid-fade fades out of the newer source, with a short jump at worst
+        previous = current;
+        current = next;
+        fadeRemaining = fadeLength;
+    }
+}
+
+void CompareSlots::processSlot(int index, juce::AudioBuffer<float>& block, FilterEngine engine)
+{
+    const auto& slot = playingSlots[static_cast<size_t>(index)];
+    auto& slotStates = states[static_cast<size_t>(index)];
+    
+    //The slots are plain cascades, so the state variable engine runs them recursively
+    if (engine == FilterEngine::blockStateSpace)
+    {
+        kernels->processCascadeBlocked(slot.sections.data(), slotStates.blocked.data(), slotStates.left.data(),
+                                       slot.numSections, block.getWritePointer(0), block.getNumSamples());
+        kernels->processCascadeBlocked(slot.sections.data(), slotStates.blocked.data(), slotStates.right.data(),
+                                       slot.numSections, block.getWritePointer(1), block.getNumSamples());
+    }
+    else
+    {
+        kernels->processCascade(slot.sections.data(), slotStates.left.data(), slot.numSections,
+                                block.getWritePointer(0), block.getNumSamples());
+        kernels->processCascade(slot.sections.data(), slotStates.right.data(), slot.numSections,
+                                block.getWritePointer(1), block.getNumSamples());
+    }
+}
+
+void CompareSlots::mixFade(juce::AudioBuffer<float>& block, const juce::AudioBuffer<float>& fadingOut)
+{
+    const auto numSamples = block.getNumSamples();
+    
+    //Linear, since both sources are the same input filtered two ways
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* output = block.getWritePointer(channel);
+        const auto* old = fadingOut.getReadPointer(channel);
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto gain = 1.0f - static_cast<float>(fadeRemaining - i) / static_cast<float>(fadeLength);
+            output[i] = old[i] + gain * (output[i] - old[i]);
+        }
+    }
+    
+    fadeRemaining -= numSamples;
+}
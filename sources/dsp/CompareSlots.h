@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    A/B/C/D compare slots, designed up front and switched with a crossfade.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include "Fifo.h"
+#include "ParallelSections.h"
+
+/** The settings of a slot and their normalised cascade, designed for one sample rate */
+struct CompareSlot
+{
+    ChainSettings settings;
+    std::array<BiquadCoefficients, ParallelDesign::maxSections> sections {};
+    int numSections = 0;
+    double sampleRate = 0;
+    bool stored = false;
+};
+
+/** Designs the cascade of a slot. Allocates, don't call it on the audio thread */
+CompareSlot makeCompareSlot(const ChainSettings& chainSettings, double sampleRate);
+
+/**
+    Holds the compare slots and plays the selected one instead of the live parameters.
+    Slots are designed on the message thread and handed over through a Fifo, so selecting
+    one only changes which sections the audio thread runs. Every slot keeps its own filter
+    state, and a change of selection crossfades from the previous source for fadeTime.
+    Stereo only, like the rest of the processor.
+ */
+class CompareSlots
+{
+public:
+    static constexpr int numSlots = 4;
+    static constexpr int live = -1;
+    static constexpr double fadeTime = 0.02;
+    
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
+    /** Redesigns the stored slots for the sample rate and sizes the crossfade, not on the audio thread */
+    void prepare(double sampleRate);
+    
+    /** Message thread: stores the settings into a slot, designed for the last prepared sample rate */
+    void store(int index, const ChainSettings& chainSettings);
+    
+    /** Message thread: plays a slot, or the live parameters again */
+    void select(int index);
+    int getSelected() const { return selected; }
+    const CompareSlot& getSlot(int index) const { return storedSlots[static_cast<size_t>(index)]; }
+    
+    /** Audio thread: picks up stored slots and the selection, starting a crossfade if it changed */
+    void update();
+    
+    /** Audio thread: false when the live parameters play on their own */
+    bool isActive() const { return current != live || fadeRemaining > 0; }
+    
+    /**
+        Audio thread: filters buffer with the selected slot. processLive(juce::AudioBuffer<float>&)
+        is only called while fading to or from the live parameters, on views of at most a
+        scratch buffer's length.
+     */
+    template<typename LiveProcess>
+    void process(juce::AudioBuffer<float>& buffer, FilterEngine engine, LiveProcess&& processLive);
+    
+private:
+    struct SlotUpdate
+    {
+        int index = 0;
+        CompareSlot slot;
+    };
+    
+    struct SlotStates
+    {
+        std::array<BiquadState, ParallelDesign::maxSections> left, right;
+        std::array<BlockedSection, ParallelDesign::maxSections> blocked; //Both channels run the same sections
+    };
+    
+    //The message thread's slots, and the copies the audio thread plays
+    std::array<CompareSlot, numSlots> storedSlots, playingSlots;
+    std::array<SlotStates, numSlots> states;
+    Fifo<SlotUpdate> slotUpdates;
+    double preparedSampleRate = 44100;
+    
+    std::atomic<int> selected { live };
+    int current = live, previous = live;
+    int fadeLength = 0, fadeRemaining = 0;
+    juce::AudioBuffer<float> fadeBuffer;
+    
+    const DspKernels* kernels = getScalarKernels();
+    
+    void processSlot(int index, juce::AudioBuffer<float>& block, FilterEngine engine);
+    void mixFade(juce::AudioBuffer<float>& block, const juce::AudioBuffer<float>& fadingOut);
+    
+    template<typename LiveProcess>
+    void processSource(int index, juce::AudioBuffer<float>& block, FilterEngine engine, LiveProcess& processLive)
+    {
+        if (index == live)
+            processLive(block);
+        else
+            processSlot(index, block, engine);
+    }
+};
+
+template<typename LiveProcess>
+void CompareSlots::process(juce::AudioBuffer<float>& buffer, FilterEngine engine, LiveProcess&& processLive)
+{
+    jassert(buffer.getNumChannels() >= 2);
+    
+    const auto numSamples = buffer.getNumSamples();
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto length = fadeRemaining > 0 ? juce::jmin(numSamples - offset, fadeRemaining, fadeBuffer.getNumSamples())
+                                              : numSamples - offset;
+        
+        //Views onto the buffer, which don't allocate for two channels
+        float* blockChannels[] = { channels[0] + offset, channels[1] + offset };
+        juce::AudioBuffer<float> block(blockChannels, 2, length);
+        
+        if (fadeRemaining > 0)
+        {
+            float* fadeChannels[] = { fadeBuffer.getWritePointer(0), fadeBuffer.getWritePointer(1) };
+            juce::AudioBuffer<float> fadingOut(fadeChannels, 2, length);
+            fadingOut.copyFrom(0, 0, block, 0, 0, length);
+            fadingOut.copyFrom(1, 0, block, 1, 0, length);
+            
+            processSource(previous, fadingOut, engine, processLive);
+            processSource(current, block, engine, processLive);
+            mixFade(block, fadingOut);
+        }
+        else
+        {
+            processSource(current, block, engine, processLive);
+        }
+        
+        offset += length;
+    }
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    The hot loops of the DSP core, compiled once per instruction set.
+
+    Each variant lives in its own translation unit under kernels/ and is built
+    with that instruction set enabled, so those files must not include JUCE or
+    any other header with inline code that could be shared with the rest of the
+    plugin. Pick a variant with selectDspKernels(), which checks the CPU.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+/** One second order section, normalised so that a0 == 1 */
+struct BiquadCoefficients
+{
+    float b0 { 1 }, b1 { 0 }, b2 { 0 }, a1 { 0 }, a2 { 0 };
+};
+
+/** The transposed direct form II state of one section, as in juce::dsp::IIR::Filter */
+struct BiquadState
+{
+    float s1 { 0 }, s2 { 0 };
+};
+
+/**
+    What DspKernels::processCascadeBlocked() derives from a section's coefficients for the
+    vector width it runs at. The caller keeps one per section from block to block, so the
+    matrices are only rebuilt when the coefficients change.
+ */
+struct BlockedSection
+{
+    static constexpr int maxWidth = 16;
+    
+    BiquadCoefficients coefficients;
+    int width = 0; //Of the kernels that built it, 0 until then
+    
+    alignas(64) float columns[maxWidth][maxWidth] {};  //H, column j in row j
+    alignas(64) float zeroInputS1[maxWidth] {};        //p
+    alignas(64) float zeroInputS2[maxWidth] {};        //q
+    float a11 = 0, a12 = 0, a21 = 0, a22 = 0;          //A
+};
+
+//Samples before the block that DspKernels::measureTruePeak() reads, for its interpolation filter
+static constexpr int truePeakHistory = 11;
+
+/** The largest magnitude and the sum of the squares of a run of samples */
+struct LevelMeasurement
+{
+    float peak { 0 }, sumOfSquares { 0 };
+};
+
+enum class InstructionSet
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512,
+    neon
+};
+
+struct DspKernels
+{
+    InstructionSet instructionSet;
+    const char* name;
+    
+    /**
+        Runs numSamples samples in place through numSections sections in series.
+        Every variant does the same arithmetic as juce::dsp::IIR::Filter, including
+        snapping the state to zero at the end of the block, so the results are
+        bit-identical unless the compiler fuses JUCE's multiply-adds (it doesn't by
+        default on x86).
+     */
+    void (*processCascade)(const BiquadCoefficients* coefficients,
+                           BiquadState* states,
+                           int numSections,
+                           float* samples,
+                           int numSamples);
+    
+    /**
+        Same as processCascade(), but each section computes a vector's width of samples at a
+        time from its block state-space form instead of one sample after another. The form is
+        built into blocked, one per section, whenever the coefficients differ from the ones it
+        was built for. It matches the recursion to within rounding errors rather than bit for
+        bit. The scalar variant just runs the recursion.
+     */
+    void (*processCascadeBlocked)(const BiquadCoefficients* coefficients,
+                                  BlockedSection* blocked,
+                                  BiquadState* states,
+                                  int numSections,
+                                  float* samples,
+                                  int numSamples);
+    
+    /**
+        Runs numSamples samples in place through numSections sections in parallel: the
+        output is direct times the input plus the sum of all the sections' outputs.
+     */
+    void (*processParallel)(const BiquadCoefficients* coefficients,
+                            BiquadState* states,
+                            int numSections,
+                            float direct,
+                            float* samples,
+                            int numSamples);
+    
+    /**
+        Replaces magnitudes with their level in decibels, like juce::Decibels::gainToDecibels().
+        The SIMD variants use a polynomial logarithm that is within 1e-4 dB of std::log10.
+     */
+    void (*gainToDecibels)(float* values, int numValues, float minusInfinityDb);
+    
+    /**
+        Measures the peak and the sum of squares of numSamples samples, for the level meters.
+        Unless copyTo is null, the samples are copied there in the same pass, which is how
+        the output meter fills the analyser's buffers.
+     */
+    LevelMeasurement (*measureLevel)(const float* samples, int numSamples, float* copyTo);
+    
+    /**
+        Returns the largest magnitude of numSamples samples upsampled 4x with the polyphase
+        interpolator of ITU-R BS.1770-4, Annex 2. The filter also reads the truePeakHistory
+        samples before samples[0], so the caller keeps them in front of each block.
+     */
+    float (*measureTruePeak)(const float* samples, int numSamples);
+    
+    /**
+        Replaces first and second in place with (first + second) * scale and (first - second) * scale:
+        left and right to mid and side with a scale of 0.5, and back again with 1.
+     */
+    void (*matrixMidSide)(float* first, float* second, int numSamples, float scale);
+};
+
+//Each returns nullptr when this build doesn't contain that variant
+const DspKernels* getScalarKernels();
+const DspKernels* getSSE2Kernels();
+const DspKernels* getAVX2Kernels();
+const DspKernels* getAVX512Kernels();
+const DspKernels* getNEONKernels();
+
+/** Returns the variant for an instruction set, or nullptr if it isn't built in or the CPU lacks it */
+const DspKernels* getDspKernels(InstructionSet instructionSet);
+
+/**
+    Returns the fastest variant this CPU supports, or the one named by the MYEQ_KERNELS
+    environment variable (scalar, sse2, avx2, avx512 or neon) if that is available.
+ */
+const DspKernels& selectDspKernels();
+
+/** Returns the forced variant if it is available here, otherwise falls back to selectDspKernels() */
+const DspKernels& selectDspKernels(InstructionSet forced);
+
+bool parseInstructionSet(const char* name, InstructionSet& result);
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    Lock-free FIFOs that hand audio from the audio thread to the analyser.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+
+template<typename T>
+struct Fifo
+{
+    void prepare(int numChannels, int numSamples)
+    {
+        static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
+                      "prepare(numChannels, numSamples) should only be use when the fifo is holding std::AudioBuffer<float>");
+        
+        for (auto& buffer : buffers)
+        {
+            buffer.setSize(numChannels,
+                           numSamples,
+                           false,       //clear everything ?
+                           true,        //including the extra space ?
+                           true);       //avoid reallocation if you can ?
+            buffer.clear();
+        }
+    }
+    
+    void prepare(size_t numElements)
+    {
+        static_assert(std::is_same_v<T, std::vector<float>>,
+                      "prepare(numElements) should only be use when the fifo is holding std::vector<float>");
+        
+        for ( auto& buffer : buffers )
+        {
+            buffer.clear();
+            buffer.resize(numElements, 0);
+        }
+        
+    }
+    
+    bool push(const T& t)
+    {
+        auto write = fifo.write(1);
+        if(write.blockSize1 > 0)
+        {
+            auto& buffer = buffers[static_cast<typename std::array<T, Capacity>::size_type>(write.startIndex1)];
+            
+            //The audio thread pushes buffers: copy them without ever reallocating
+            if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+                buffer.makeCopyOf(t, true);
+            else
+                buffer = t;
+            return true;
+        }
+        return false;
+    }
+    
+    bool pull(T& t)
+    {
+        auto read = fifo.read(1);
+        if(read.blockSize1 > 0)
+        {
+            t = buffers[static_cast<typename std::array<T, Capacity>::size_type>(read.startIndex1)];
+            return true;
+        }
+        return false;
+    }
+    
+    int getNumAvailableForReading() const
+    {
+        return fifo.getNumReady();
+    }
+    
+private:
+    static constexpr int Capacity = 30;
+    std::array<T, Capacity> buffers;
+    juce::AbstractFifo fifo {Capacity};
+};
+
+enum Channel
+{
+    Right, //Effectively 0
+    Left //Effectively 1
+};
+
+template<typename BlockType>
+struct SingleChannelSampleFifo
+{
+    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
+    {
+        prepared.set(false);
+    }
+    
+    void update(const BlockType& buffer)
+    {
+        jassert(prepared.get());
+        jassert(buffer.getNumChannels() > channelToUse);
+        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        
+        for ( int i = 0; i < buffer.getNumSamples(); )
+        {
+            float* destination;
+            auto numToCopy = juce::jmin(prepareToWrite(destination), buffer.getNumSamples() - i);
+            juce::FloatVectorOperations::copy(destination, channelPtr + i, numToCopy);
+            finishedWrite(numToCopy);
+            i += numToCopy;
+        }
+    }
+    
+    /**
+        Lets a pass that already reads the block write the samples itself instead of
+        update() going over them again: points destination at the free space of the buffer
+        being filled and returns its length, then finishedWrite() takes what was written.
+     */
+    int prepareToWrite(float*& destination)
+    {
+        jassert(prepared.get());
+        
+        if ( fifoIndex == bufferToFill.getNumSamples() )
+        {
+            auto ok = audioBufferFifo.push(bufferToFill);
+            
+            juce::ignoreUnused(ok);
+            
+            fifoIndex = 0;
+        }
+        
+        destination = bufferToFill.getWritePointer(0, fifoIndex);
+        return bufferToFill.getNumSamples() - fifoIndex;
+    }
+    
+    void finishedWrite(int numWritten)
+    {
+        jassert(numWritten >= 0 && fifoIndex + numWritten <= bufferToFill.getNumSamples());
+        fifoIndex += numWritten;
+    }
+    
+    void prepare(int bufferSize)
+    {
+        prepared.set(false);
+        size.set(bufferSize);
+        
+        bufferToFill.setSize(1,             //Channel
+                             bufferSize,    //Num Sample
+                             false,         //KeepExistingContent
+                             true,          //Clear extra space
+                             true);         //avoid reallocating
+        
+        audioBufferFifo.prepare(1, bufferSize);
+        fifoIndex = 0;
+        prepared.set(true);
+    }
+    
+    //==============================================================================
+    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    bool isPrepared() const { return prepared.get(); }
+    int getSize() const { return size.get(); }
+    //==============================================================================
+    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    Channel getChannel() const { return channelToUse; }
+private:
+    Channel channelToUse;
+    int fifoIndex = 0;
+    Fifo<BlockType> audioBufferFifo;
+    BlockType bufferToFill;
+    juce::Atomic<bool> prepared = false;
+    juce::Atomic<int> size = 0;
+};
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    The filter chain shared by the plugin, the renderer and the benchmarks.
+
+  ==============================================================================
+*/
+
+#include "FilterChain.h"
+
+void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+{
+    *old = *replacements;
+}
+
+void updateCoefficients(Coefficients &old, const CoefficientArray &replacements)
+{
+    //Normalises in place into the existing storage
+    *old = replacements;
+}
+
+Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
+                                                               chainSettings.peakFreq,
+                                                               chainSettings.peakQuality,
+                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+}
+
+CoefficientArray makePeakCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    return juce::dsp::IIR::ArrayCoefficients<float>::makePeakFilter(sampleRate,
+                                                                    chainSettings.peakFreq,
+                                                                    chainSettings.peakQuality,
+                                                                    juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+}
+
+float getButterworthQuality(int index, int order)
+{
+    return static_cast<float>(1.0 / (2.0 * std::cos((2.0 * index + 1.0) * juce::MathConstants<double>::pi / (order * 2.0))));
+}
+
+//Same sections as FilterDesign::designIIR...HighOrderButterworthMethod, without the ReferenceCountedArray
+static CutCoefficientArrays makeButterworthCoefficients(bool highPass, float frequency, Slope slope, double sampleRate)
+{
+    CutCoefficientArrays coefficients {};
+    
+    const auto order = 2 * (slope + 1);
+    for (int i = 0; i < order / 2; ++i)
+    {
+        auto q = getButterworthQuality(i, order);
+        
+        coefficients[static_cast<size_t>(i)] = highPass
+            ? juce::dsp::IIR::ArrayCoefficients<float>::makeHighPass(sampleRate, frequency, q)
+            : juce::dsp::IIR::ArrayCoefficients<float>::makeLowPass(sampleRate, frequency, q);
+    }
+    return coefficients;
+}
+
+CutCoefficientArrays makeLowCutCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeButterworthCoefficients(true, chainSettings.lowCutFreq, chainSettings.lowCutSlope, sampleRate);
+}
+
+CutCoefficientArrays makeHighCutCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeButterworthCoefficients(false, chainSettings.highCutFreq, chainSettings.highCutSlope, sampleRate);
+}
+
+void updateMonoChain(MonoChain& chain, const ChainSettings& chainSettings, double sampleRate)
+{
+    chain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    chain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    chain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makePeakCoefficients(chainSettings, sampleRate));
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), makeLowCutCoefficients(chainSettings, sampleRate), chainSettings.lowCutSlope);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), makeHighCutCoefficients(chainSettings, sampleRate), chainSettings.highCutSlope);
+}
+
+void KernelCascade::reset()
+{
+    states.fill({});
+    active.fill(false);
+}
+
+void KernelCascade::process(const MonoChain& chain, float* samples, int numSamples, FilterEngine engine)
+{
+    std::array<BiquadCoefficients, maxSections> activeCoefficients;
+    std::array<BiquadState, maxSections> activeStates;
+    std::array<size_t, maxSections> statePositions;
+    const auto wasActive = active;
+    size_t numActive = 0;
+    active.fill(false);
+    
+    auto addSection = [&](const Filter& filter, size_t statePosition)
+    {
+        jassert(filter.coefficients->getFilterOrder() == 2);
+        auto* c = filter.coefficients->getRawCoefficients();
+        
+        //A stale state from before the section was bypassed would click
+        if (! wasActive[statePosition])
+            states[statePosition] = {};
+        
+        active[statePosition] = true;
+        activeCoefficients[numActive] = { c[0], c[1], c[2], c[3], c[4] };
+        activeStates[numActive] = states[statePosition];
+        statePositions[numActive] = statePosition;
+        ++numActive;
+    };
+    
+    auto addCutFilter = [&](const CutFilter& cut, size_t firstStatePosition)
+    {
+        if (! cut.isBypassed<0>()) addSection(cut.get<0>(), firstStatePosition);
+        if (! cut.isBypassed<1>()) addSection(cut.get<1>(), firstStatePosition + 1);
+        if (! cut.isBypassed<2>()) addSection(cut.get<2>(), firstStatePosition + 2);
+        if (! cut.isBypassed<3>()) addSection(cut.get<3>(), firstStatePosition + 3);
+    };
+    
+    if (! chain.isBypassed<ChainPositions::LowCut>())
+        addCutFilter(chain.get<ChainPositions::LowCut>(), 0);
+    
+    if (! chain.isBypassed<ChainPositions::Peak>())
+        addSection(chain.get<ChainPositions::Peak>(), 4);
+    
+    if (! chain.isBypassed<ChainPositions::HighCut>())
+        addCutFilter(chain.get<ChainPositions::HighCut>(), 5);
+    
+    //FilterEngine::stateVariable doesn't use the chain's biquads at all, see SvfCascade
+    jassert(engine != FilterEngine::stateVariable);
+    
+    if (engine == FilterEngine::blockStateSpace)
+        kernels->processCascadeBlocked(activeCoefficients.data(), blocked.data(), activeStates.data(),
+                                       static_cast<int>(numActive), samples, numSamples);
+    else
+        kernels->processCascade(activeCoefficients.data(), activeStates.data(), static_cast<int>(numActive), samples, numSamples);
+    
+    for (size_t i = 0; i < numActive; ++i)
+        states[statePositions[i]] = activeStates[i];
+}
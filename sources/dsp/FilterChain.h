@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    The filter chain shared by the plugin, the renderer and the benchmarks.
+    Only depends on juce_dsp, see the myEQ_dsp target in CMakeLists.txt.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include "DspKernels.h"
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+struct ChainSettings
+{
+    float peakFreq{0}, peakGainInDecibels{0}, peakQuality{0};
+    float lowCutFreq{0}, highCutFreq{0};
+    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+    bool lowCutBypassed { false }, peakBypassed { false }, highCutBypassed { false };
+};
+
+using Filter = juce::dsp::IIR::Filter<float>;
+
+using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+
+using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+
+enum ChainPositions
+{
+    LowCut,
+    Peak,
+    HighCut
+};
+
+using Coefficients = Filter::CoefficientsPtr;
+void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+
+Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+
+//Raw b0, b1, b2, a0, a1, a2 as designed by juce::dsp::IIR::ArrayCoefficients
+using CoefficientArray = std::array<float, 6>;
+using CutCoefficientArrays = std::array<CoefficientArray, 4>;
+
+//These don't allocate, so unlike the designs above they are safe to use on the audio thread
+void updateCoefficients(Coefficients& old, const CoefficientArray& replacements);
+
+CoefficientArray makePeakCoefficients(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficientArrays makeLowCutCoefficients(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficientArrays makeHighCutCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+//Q of the second order section at index of a Butterworth filter of the given (even) order
+float getButterworthQuality(int index, int order);
+
+template<int Index, typename ChainType, typename CoefficientType>
+void update(ChainType& chain, CoefficientType& cutCoefficients)
+{
+    updateCoefficients(chain.template get<Index>().coefficients, cutCoefficients[Index]);
+    chain.template setBypassed<Index>(false);
+}
+
+template<typename ChainType, typename CoefficientType>
+void updateCutFilter(ChainType& chain,
+                     const CoefficientType& coefficients,
+                     const Slope& slope)
+{
+    chain.template setBypassed<0>(true);
+    chain.template setBypassed<1>(true);
+    chain.template setBypassed<2>(true);
+    chain.template setBypassed<3>(true);
+    
+    switch ( slope )
+    {
+        case Slope_48:
+        {
+            update<3>(chain, coefficients);
+        }
+        case Slope_36:
+        {
+            update<2>(chain, coefficients);
+        }
+        case Slope_24:
+        {
+            update<1>(chain, coefficients);
+        }
+        case Slope_12:
+        {
+            update<0>(chain, coefficients);
+        }
+    }
+}
+
+/** Designs all of a chain's sections and bypass states from the settings, without allocating */
+void updateMonoChain(MonoChain& chain, const ChainSettings& chainSettings, double sampleRate);
+
+inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
+                                                                                       sampleRate,
+                                                                                       2 *(chainSettings.lowCutSlope + 1));
+    //For the order parameter, it is changing the slope choice (0/1/2/3) in filter order (2/4/6/8)
+}
+
+inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
+                                                                                      sampleRate,
+                                                                                      2 *(chainSettings.highCutSlope + 1));
+    //For the order parameter, it is changing the slope choice (0/1/2/3) in filter order (2/4/6/8)
+}
+
+/** How the processor computes the sections */
+enum class FilterEngine
+{
+    recursive,       //DspKernels::processCascade(), bit-exact with juce::dsp::IIR::Filter
+    blockStateSpace, //DspKernels::processCascadeBlocked(), for offline rendering and settings that hold still
+    stateVariable    //SvfCascade, for cheap and smooth parameter changes
+};
+
+//Bit for bit, since only then do two filters fed the same samples stay identical
+template<size_t numStates>
+bool statesEqual(const std::array<BiquadState, numStates>& a, const std::array<BiquadState, numStates>& b)
+{
+    for (size_t i = 0; i < numStates; ++i)
+        if (a[i].s1 != b[i].s1 || a[i].s2 != b[i].s2)
+            return false;
+    
+    return true;
+}
+
+/**
+    Runs the sections of a MonoChain that aren't bypassed through DspKernels::processCascade().
+    The chain only provides the coefficients and bypass states. The filter state lives here,
+    one per section. Unlike in the chain itself, a section that comes back from bypass, or that
+    a steeper slope brings in, starts from silence rather than from the state it was left with.
+    Both engines use the same state, so they can be switched between blocks.
+ */
+class KernelCascade
+{
+public:
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    const DspKernels& getKernels() const { return *kernels; }
+    
+    void reset();
+    void process(const MonoChain& chain, float* samples, int numSamples,
+                 FilterEngine engine = FilterEngine::recursive);
+    
+    /** For dual mono: whether both would produce the same output, and handing one's state to the other */
+    bool hasSameState(const KernelCascade& other) const { return active == other.active && statesEqual(states, other.states); }
+    void copyStateFrom(const KernelCascade& other) { states = other.states; active = other.active; }
+    
+private:
+    //Four sections per cut filter and the peak filter
+    static constexpr size_t maxSections = 9;
+    
+    std::array<BiquadState, maxSections> states;
+    std::array<bool, maxSections> active {}; //Which sections ran in the last block
+    std::array<BlockedSection, maxSections> blocked; //The block engine's matrices, per active section
+    const DspKernels* kernels = getScalarKernels();
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    Peak and RMS metering, measured on the audio thread and read by the editor.
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+void LevelMeter::measure(const juce::AudioBuffer<float>& buffer)
+{
+    const auto numSamples = buffer.getNumSamples();
+    if (numSamples == 0)
+        return;
+    
+    for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); ++channel)
+        publish(channel, kernels->measureLevel(buffer.getReadPointer(channel), numSamples, nullptr), numSamples);
+}
+
+void LevelMeter::measure(const juce::AudioBuffer<float>& buffer, AnalyserTap& firstTap, AnalyserTap& secondTap)
+{
+    const auto numSamples = buffer.getNumSamples();
+    if (numSamples == 0)
+        return;
+    
+    for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); ++channel)
+    {
+        //The taps name the channel they read, which isn't necessarily the order they're passed in
+        AnalyserTap* tap = nullptr;
+        for (auto* candidate : { &firstTap, &secondTap })
+            if (static_cast<int>(candidate->getChannel()) == channel && candidate->isPrepared())
+                tap = candidate;
+        
+        if (tap == nullptr)
+        {
+            publish(channel, kernels->measureLevel(buffer.getReadPointer(channel), numSamples, nullptr), numSamples);
+            continue;
+        }
+        
+        //The tap's buffer wraps around at its own size, so the block is measured in pieces
+        const auto* samples = buffer.getReadPointer(channel);
+        LevelMeasurement level;
+        
+        for (int i = 0; i < numSamples; )
+        {
+            float* destination;
+            const auto length = juce::jmin(tap->prepareToWrite(destination), numSamples - i);
+            const auto piece = kernels->measureLevel(samples + i, length, destination);
+            tap->finishedWrite(length);
+            
+            level.peak = juce::jmax(level.peak, piece.peak);
+            level.sumOfSquares += piece.sumOfSquares;
+            i += length;
+        }
+        
+        publish(channel, level, numSamples);
+    }
+}
+
+void LevelMeter::publish(int channel, LevelMeasurement level, int numSamples)
+{
+    //Only ever raises the peak, so a take() in between isn't undone
+    auto& peak = peaks[static_cast<size_t>(channel)];
+    auto held = peak.load(std::memory_order_relaxed);
+    while (level.peak > held && ! peak.compare_exchange_weak(held, level.peak, std::memory_order_relaxed))
+        ;
+    
+    //Summed until the editor takes it. With the editor closed nobody does, so the sum starts
+    //over before the float stops resolving a block's worth of samples
+    static constexpr juce::uint32 maxSummedSamples = 1 << 20;
+    
+    auto& sumOfSquares = sumsOfSquares[static_cast<size_t>(channel)];
+    auto summed = sumOfSquares.load(std::memory_order_relaxed);
+    SumOfSquares next;
+    
+    do
+    {
+        next = summed.numSamples < maxSummedSamples ? summed : SumOfSquares {};
+        next.sum += level.sumOfSquares;
+        next.numSamples += static_cast<juce::uint32>(numSamples);
+    }
+    while (! sumOfSquares.compare_exchange_weak(summed, next, std::memory_order_relaxed));
+}
+
+LevelMeter::Reading LevelMeter::take(int channel)
+{
+    jassert(channel >= 0 && channel < numChannels);
+    
+    Reading reading;
+    reading.peak = peaks[static_cast<size_t>(channel)].exchange(0, std::memory_order_relaxed);
+    
+    //Nothing played since the last call reads as silence, like the peak
+    auto summed = sumsOfSquares[static_cast<size_t>(channel)].exchange({}, std::memory_order_relaxed);
+    if (summed.numSamples > 0)
+        reading.meanSquare = summed.sum / static_cast<float>(summed.numSamples);
+    
+    return reading;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    Peak and RMS metering, measured on the audio thread and read by the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include "DspKernels.h"
+#include "Fifo.h"
+
+/**
+    Measures the first two channels of every block with DspKernels::measureLevel() and
+    publishes the result through atomics. The peak and the sum of squares are held until the
+    editor takes them, so the reading covers every sample since the last repaint however small
+    the sub-blocks are.
+    Ballistics are left to the reader, see MeterBallistics in PluginEditor.h.
+ */
+class LevelMeter
+{
+public:
+    static constexpr int numChannels = 2;
+    
+    using AnalyserTap = SingleChannelSampleFifo<juce::AudioBuffer<float>>;
+    
+    struct Reading
+    {
+        float peak = 0, meanSquare = 0;
+    };
+    
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
+    /** Audio thread */
+    void measure(const juce::AudioBuffer<float>& buffer);
+    
+    /**
+        Audio thread: also copies each channel into the analyser fifo reading it while the
+        samples are loaded for the measurement, so the analyser needs no pass of its own
+     */
+    void measure(const juce::AudioBuffer<float>& buffer, AnalyserTap& firstTap, AnalyserTap& secondTap);
+    
+    /** Any thread: the peak and the mean square since the last call */
+    Reading take(int channel);
+    
+private:
+    //Summed together so take() never sees a sum without its sample count
+    struct SumOfSquares
+    {
+        float sum = 0;
+        juce::uint32 numSamples = 0;
+    };
+    
+    void publish(int channel, LevelMeasurement level, int numSamples);
+    
+    std::array<std::atomic<float>, numChannels> peaks {};
+    std::array<std::atomic<SumOfSquares>, numChannels> sumsOfSquares {};
+    const DspKernels* kernels = getScalarKernels();
+};
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    EBU R128 / ITU-R BS.1770 loudness: momentary, short-term and integrated.
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+
+static float energyToLoudness(double energy)
+{
+    return energy > 0 ? static_cast<float>(-0.691 + 10.0 * std::log10(energy)) : -std::numeric_limits<float>::infinity();
+}
+
+static double loudnessToEnergy(double loudness)
+{
+    return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+static double getBinLoudness(int bin)
+{
+    return LoudnessMeter::absoluteGate + (bin + 0.5) * LoudnessMeter::histogramStep;
+}
+
+/*
+    The BS.1770 filters at any sample rate, from their analog prototypes through the
+    bilinear transform as in libebur128. At 48 kHz they match the coefficients of the
+    recommendation.
+ */
+static std::array<BiquadCoefficients, 2> makeKWeighting(double sampleRate)
+{
+    const auto pi = juce::MathConstants<double>::pi;
+    
+    auto K = std::tan(pi * 1681.974450955533 / sampleRate);
+    auto Q = 0.7071752369554196;
+    auto Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    auto Vb = std::pow(Vh, 0.4996667741545416);
+    auto a0 = 1.0 + K / Q + K * K;
+    
+    BiquadCoefficients shelf;
+    shelf.b0 = static_cast<float>((Vh + Vb * K / Q + K * K) / a0);
+    shelf.b1 = static_cast<float>(2.0 * (K * K - Vh) / a0);
+    shelf.b2 = static_cast<float>((Vh - Vb * K / Q + K * K) / a0);
+    shelf.a1 = static_cast<float>(2.0 * (K * K - 1.0) / a0);
+    shelf.a2 = static_cast<float>((1.0 - K / Q + K * K) / a0);
+    
+    K = std::tan(pi * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    
+    BiquadCoefficients highPass;
+    highPass.b0 = 1.0f;
+    highPass.b1 = -2.0f;
+    highPass.b2 = 1.0f;
+    highPass.a1 = static_cast<float>(2.0 * (K * K - 1.0) / a0);
+    highPass.a2 = static_cast<float>((1.0 - K / Q + K * K) / a0);
+    
+    return { shelf, highPass };
+}
+
+//==============================================================================
+void LoudnessMeter::prepare(double sampleRate)
+{
+    kWeighting = makeKWeighting(sampleRate);
+    states = {};
+    
+    blockLength = juce::jmax(1, juce::roundToInt(0.1 * sampleRate));
+    blockPosition = 0;
+    blockEnergy = 0;
+    numBlockEnergies = nextBlockEnergy = 0;
+    
+    for (auto& bin : histogram)
+        bin.store(0, std::memory_order_relaxed);
+    
+    integratedResetRequested = false;
+    momentary = absoluteGate;
+    shortTerm = absoluteGate;
+}
+
+void LoudnessMeter::measure(const juce::AudioBuffer<float>& buffer)
+{
+    const auto numSamples = buffer.getNumSamples();
+    const auto channels = juce::jmin(numChannels, buffer.getNumChannels());
+    
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto length = juce::jmin(chunkSize, numSamples - offset, blockLength - blockPosition);
+        
+        //The energies of the channels add up, each with a weight of 1 for left and right
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            const auto* input = buffer.getReadPointer(channel, offset);
+            std::copy(input, input + length, filtered.begin());
+            
+            kernels->processCascade(kWeighting.data(), states[static_cast<size_t>(channel)].data(),
+                                    static_cast<int>(kWeighting.size()), filtered.data(), length);
+            blockEnergy += kernels->measureLevel(filtered.data(), length, nullptr).sumOfSquares;
+        }
+        
+        offset += length;
+        blockPosition += length;
+        
+        if (blockPosition == blockLength)
+            finishBlock();
+    }
+}
+
+void LoudnessMeter::finishBlock()
+{
+    blockEnergies[static_cast<size_t>(nextBlockEnergy)] = blockEnergy / blockLength;
+    nextBlockEnergy = (nextBlockEnergy + 1) % static_cast<int>(blockEnergies.size());
+    numBlockEnergies = juce::jmin(numBlockEnergies + 1, static_cast<int>(blockEnergies.size()));
+    blockPosition = 0;
+    blockEnergy = 0;
+    
+    if (integratedResetRequested.exchange(false))
+        for (auto& bin : histogram)
+            bin.store(0, std::memory_order_relaxed);
+    
+    //Until there are 400 ms, the window is just shorter
+    const auto momentaryLoudness = energyToLoudness(getMeanEnergy(4));
+    momentary.store(juce::jmax(absoluteGate, momentaryLoudness), std::memory_order_relaxed);
+    shortTerm.store(juce::jmax(absoluteGate, energyToLoudness(getMeanEnergy(30))), std::memory_order_relaxed);
+    
+    //The 400 ms gating blocks overlap by 75%, so each is the momentary window once it is full
+    if (numBlockEnergies >= 4 && momentaryLoudness > absoluteGate)
+    {
+        auto bin = static_cast<int>((momentaryLoudness - absoluteGate) / histogramStep);
+        auto& count = histogram[static_cast<size_t>(juce::jmin(bin, histogramBins - 1))];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+double LoudnessMeter::getMeanEnergy(int numBlocks) const
+{
+    numBlocks = juce::jmin(numBlocks, numBlockEnergies);
+    if (numBlocks == 0)
+        return 0;
+    
+    double sum = 0;
+    auto index = nextBlockEnergy;
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        index = (index + static_cast<int>(blockEnergies.size()) - 1) % static_cast<int>(blockEnergies.size());
+        sum += blockEnergies[static_cast<size_t>(index)];
+    }
+    
+    return sum / numBlocks;
+}
+
+float LoudnessMeter::getIntegratedLoudness() const
+{
+    std::array<juce::uint32, histogramBins> counts;
+    for (size_t i = 0; i < counts.size(); ++i)
+        counts[i] = histogram[i].load(std::memory_order_relaxed);
+    
+    //Each block counts with the energy at the centre of its bin, at most 0.05 LU off
+    auto gatedMean = [&counts](int firstBin)
+    {
+        double energy = 0, numBlocks = 0;
+        for (auto bin = firstBin; bin < histogramBins; ++bin)
+        {
+            energy += counts[static_cast<size_t>(bin)] * loudnessToEnergy(getBinLoudness(bin));
+            numBlocks += counts[static_cast<size_t>(bin)];
+        }
+        return numBlocks > 0 ? energy / numBlocks : 0.0;
+    };
+    
+    //Above the absolute gate already, then again above the relative one
+    auto ungated = gatedMean(0);
+    if (ungated <= 0)
+        return absoluteGate;
+    
+    auto threshold = energyToLoudness(ungated) + relativeGate;
+    auto firstBin = juce::jlimit(0, histogramBins, static_cast<int>(std::ceil((threshold - absoluteGate) / histogramStep - 0.5f)));
+    
+    return juce::jmax(absoluteGate, energyToLoudness(gatedMean(firstBin)));
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    EBU R128 / ITU-R BS.1770 loudness: momentary, short-term and integrated.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include "DspKernels.h"
+
+/**
+    Streams the K-weighted energy of the first two channels into 100 ms blocks. The last
+    4 blocks give the momentary loudness and the last 30 the short-term loudness, both
+    published through atomics. Every 100 ms the momentary block also goes into a fixed
+    histogram of 0.1 LU bins for the integrated loudness, so gating costs O(1) per block
+    on the audio thread and the memory doesn't grow with the length of the programme.
+    The two-pass gating itself only runs when getIntegratedLoudness() is called.
+ */
+class LoudnessMeter
+{
+public:
+    static constexpr int numChannels = 2;
+    
+    //The absolute gate, also what the meter reads in silence
+    static constexpr float absoluteGate = -70.f;
+    static constexpr float relativeGate = -10.f;
+    
+    //From the absolute gate to +5 LUFS, louder blocks go in the last bin
+    static constexpr float histogramStep = 0.1f;
+    static constexpr int histogramBins = 750;
+    
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
+    /** Designs the K-weighting for the sample rate and resets everything, not on the audio thread */
+    void prepare(double sampleRate);
+    
+    /** Audio thread */
+    void measure(const juce::AudioBuffer<float>& buffer);
+    
+    /** Any thread, in LUFS */
+    float getMomentaryLoudness() const { return momentary.load(std::memory_order_relaxed); }
+    float getShortTermLoudness() const { return shortTerm.load(std::memory_order_relaxed); }
+    float getIntegratedLoudness() const;
+    
+    /** Any thread: starts a new integrated measurement from the next block */
+    void resetIntegrated() { integratedResetRequested = true; }
+    
+private:
+    //The high shelf then the high pass of BS.1770's K-weighting
+    std::array<BiquadCoefficients, 2> kWeighting {};
+    std::array<std::array<BiquadState, 2>, numChannels> states {};
+    
+    //Filtered in chunks, so the block size doesn't matter
+    static constexpr int chunkSize = 256;
+    std::array<float, chunkSize> filtered {};
+    
+    int blockLength = 4800, blockPosition = 0;
+    double blockEnergy = 0;
+    
+    //The mean square of the last 30 blocks (3 s), summed over the channels
+    std::array<double, 30> blockEnergies {};
+    int numBlockEnergies = 0, nextBlockEnergy = 0;
+    
+    std::array<std::atomic<juce::uint32>, histogramBins> histogram {};
+    std::atomic<bool> integratedResetRequested { false };
+    std::atomic<float> momentary { absoluteGate }, shortTerm { absoluteGate };
+    
+    const DspKernels* kernels = getScalarKernels();
+    
+    void finishBlock();
+    double getMeanEnergy(int numBlocks) const;
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    Morphing between two ChainSettings snapshots.
+
+  ==============================================================================
+*/
+
+#include "Morph.h"
+
+//The ends of the frequency parameters' range, where a cut filter does the least
+static constexpr float lowestFrequency = 20.f;
+static constexpr float highestFrequency = 20000.f;
+
+static float interpolateLog(float a, float b, float amount)
+{
+    return a * std::pow(b / a, amount);
+}
+
+static float interpolateLinear(float a, float b, float amount)
+{
+    return a + (b - a) * amount;
+}
+
+MorphedSettings morphChainSettings(const MorphSnapshots& snapshots, float amount)
+{
+    const auto& a = snapshots.a;
+    const auto& b = snapshots.b;
+    amount = juce::jlimit(0.f, 1.f, amount);
+    
+    ChainSettings settings;
+    
+    //Whichever end has the band bypassed contributes its neutral setting instead
+    auto lowCutA = a.lowCutBypassed ? lowestFrequency : a.lowCutFreq;
+    auto lowCutB = b.lowCutBypassed ? lowestFrequency : b.lowCutFreq;
+    settings.lowCutFreq = interpolateLog(lowCutA, lowCutB, amount);
+    
+    auto highCutA = a.highCutBypassed ? highestFrequency : a.highCutFreq;
+    auto highCutB = b.highCutBypassed ? highestFrequency : b.highCutFreq;
+    settings.highCutFreq = interpolateLog(highCutA, highCutB, amount);
+    
+    //Without a gain the frequency and Q of a bypassed peak don't matter, so they follow the other end
+    settings.peakFreq = interpolateLog(a.peakBypassed ? b.peakFreq : a.peakFreq,
+                                       b.peakBypassed ? a.peakFreq : b.peakFreq, amount);
+    settings.peakQuality = interpolateLog(a.peakBypassed ? b.peakQuality : a.peakQuality,
+                                          b.peakBypassed ? a.peakQuality : b.peakQuality, amount);
+    settings.peakGainInDecibels = interpolateLinear(a.peakBypassed ? 0.f : a.peakGainInDecibels,
+                                                    b.peakBypassed ? 0.f : b.peakGainInDecibels, amount);
+    
+    auto isBypassed = [amount](bool bypassedInA, bool bypassedInB)
+    {
+        return (bypassedInA && bypassedInB) || (bypassedInA && amount <= 0.f) || (bypassedInB && amount >= 1.f);
+    };
+    
+    settings.lowCutBypassed = isBypassed(a.lowCutBypassed, b.lowCutBypassed);
+    settings.peakBypassed = isBypassed(a.peakBypassed, b.peakBypassed);
+    settings.highCutBypassed = isBypassed(a.highCutBypassed, b.highCutBypassed);
+    
+    MorphedSettings morphed;
+    morphed.from = morphed.to = settings;
+    
+    //A bypassed end has no slope of its own, so it takes the other end's rather than crossfading
+    morphed.from.lowCutSlope = a.lowCutBypassed ? b.lowCutSlope : a.lowCutSlope;
+    morphed.from.highCutSlope = a.highCutBypassed ? b.highCutSlope : a.highCutSlope;
+    morphed.to.lowCutSlope = b.lowCutBypassed ? a.lowCutSlope : b.lowCutSlope;
+    morphed.to.highCutSlope = b.highCutBypassed ? a.highCutSlope : b.highCutSlope;
+    morphed.crossfade = amount;
+    
+    return morphed;
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    Morphing between two ChainSettings snapshots.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+/** The two ends of a morph, A at 0 and B at 1 */
+struct MorphSnapshots
+{
+    ChainSettings a, b;
+    bool hasA = false, hasB = false;
+    
+    bool isComplete() const { return hasA && hasB; }
+};
+
+/**
+    The settings part of the way from A to B. Everything but the slopes is interpolated,
+    and the same in both: from has A's slopes and to has B's, and the outputs of the two
+    cascades are crossfaded by amount when they differ, since a slope can't be in between.
+ */
+struct MorphedSettings
+{
+    ChainSettings from, to;
+    float crossfade = 0;
+    
+    bool needsCrossfade() const { return from.lowCutSlope != to.lowCutSlope || from.highCutSlope != to.highCutSlope; }
+};
+
+/**
+    Interpolates where the ear would: frequencies and Q on a log scale, gain in dB.
+    A band bypassed at one end fades in from neutral: 0 dB for the peak, the bottom or
+    top of the range for the cuts, and is only bypassed at that very end.
+    Cheap and allocation-free, for the audio thread.
+ */
+MorphedSettings morphChainSettings(const MorphSnapshots& snapshots, float amount);
+
+//Samples between two coefficient redesigns while morphing
+static constexpr int morphControlInterval = 64;
@@ -0,0 +1,259 @@
+/*
+  ==============================================================================
+
+    The combined EQ response as a parallel sum of second order sections.
+
+  ==============================================================================
+*/
+
+#include "ParallelSections.h"
+#include <complex>
+#include <vector>
+
+bool operator==(const ChainSettings& a, const ChainSettings& b)
+{
+    return a.peakFreq == b.peakFreq
+        && a.peakGainInDecibels == b.peakGainInDecibels
+        && a.peakQuality == b.peakQuality
+        && a.lowCutFreq == b.lowCutFreq
+        && a.highCutFreq == b.highCutFreq
+        && a.lowCutSlope == b.lowCutSlope
+        && a.highCutSlope == b.highCutSlope
+        && a.lowCutBypassed == b.lowCutBypassed
+        && a.peakBypassed == b.peakBypassed
+        && a.highCutBypassed == b.highCutBypassed;
+}
+
+bool operator!=(const ChainSettings& a, const ChainSettings& b)
+{
+    return ! (a == b);
+}
+
+int makeCascadeSections(const ChainSettings& chainSettings, double sampleRate,
+                        std::array<BiquadCoefficients, ParallelDesign::maxSections>& sections)
+{
+    int numSections = 0;
+    
+    //Normalised the way juce::dsp::IIR::Coefficients does it, so these match the chain
+    auto addSection = [&](const CoefficientArray& c)
+    {
+        const auto a0Inverse = 1.0f / c[3];
+        sections[static_cast<size_t>(numSections++)] = { c[0] * a0Inverse, c[1] * a0Inverse, c[2] * a0Inverse,
+                                                         c[4] * a0Inverse, c[5] * a0Inverse };
+    };
+    
+    if (! chainSettings.lowCutBypassed)
+    {
+        auto lowCut = makeLowCutCoefficients(chainSettings, sampleRate);
+        for (int i = 0; i <= static_cast<int>(chainSettings.lowCutSlope); ++i)
+            addSection(lowCut[static_cast<size_t>(i)]);
+    }
+    
+    if (! chainSettings.peakBypassed)
+        addSection(makePeakCoefficients(chainSettings, sampleRate));
+    
+    if (! chainSettings.highCutBypassed)
+    {
+        auto highCut = makeHighCutCoefficients(chainSettings, sampleRate);
+        for (int i = 0; i <= static_cast<int>(chainSettings.highCutSlope); ++i)
+            addSection(highCut[static_cast<size_t>(i)]);
+    }
+    
+    return numSections;
+}
+
+//==============================================================================
+using Complex = std::complex<double>;
+
+/*
+    With the denominators factored into poles p, H(z) = direct + sum r / (1 - p z^-1),
+    and the residue of a simple pole is
+        r_i = prod_k N_k(p_i) / (p_i prod_{j != i} (p_i - p_j))
+    where N_k(z) = b0 z^2 + b1 z + b2 are the section numerators. Two conjugate (or two
+    real) poles of the same section add back up to a real second order section.
+ */
+static bool expand(const std::array<BiquadCoefficients, ParallelDesign::maxSections>& cascade,
+                   int numSections,
+                   ParallelDesign& design)
+{
+    const auto numPoles = static_cast<size_t>(2 * numSections);
+    std::array<Complex, 2 * ParallelDesign::maxSections> poles, residues;
+    
+    for (size_t k = 0; k < static_cast<size_t>(numSections); ++k)
+    {
+        const auto a1 = static_cast<double>(cascade[k].a1);
+        const auto a2 = static_cast<double>(cascade[k].a2);
+        const auto root = std::sqrt(Complex(a1 * a1 - 4.0 * a2));
+        
+        poles[2 * k] = (-a1 + root) * 0.5;
+        poles[2 * k + 1] = (-a1 - root) * 0.5;
+    }
+    
+    constexpr double minimumDistance = 1.0e-9;
+    
+    for (size_t i = 0; i < numPoles; ++i)
+    {
+        const auto p = poles[i];
+        
+        //A pole at the origin is a pure delay, which this form can't hold
+        if (std::abs(p) < minimumDistance)
+            return false;
+        
+        Complex numerator = 1, denominator = p;
+        
+        for (size_t k = 0; k < static_cast<size_t>(numSections); ++k)
+            numerator *= (static_cast<double>(cascade[k].b0) * p + static_cast<double>(cascade[k].b1)) * p
+                        + static_cast<double>(cascade[k].b2);
+        
+        for (size_t j = 0; j < numPoles; ++j)
+        {
+            if (j == i)
+                continue;
+            
+            //Repeated poles need higher order terms
+            if (std::abs(p - poles[j]) < minimumDistance)
+                return false;
+            
+            denominator *= p - poles[j];
+        }
+        
+        residues[i] = numerator / denominator;
+    }
+    
+    double gain = 1, residueSum = 0;
+    
+    for (size_t k = 0; k < static_cast<size_t>(numSections); ++k)
+    {
+        const auto r1 = residues[2 * k], r2 = residues[2 * k + 1];
+        const auto p1 = poles[2 * k], p2 = poles[2 * k + 1];
+        
+        //r1 / (1 - p1 z^-1) + r2 / (1 - p2 z^-1) over the section's own denominator
+        design.sections[k] = { static_cast<float>((r1 + r2).real()),
+                               static_cast<float>(-(r1 * p2 + r2 * p1).real()),
+                               0.0f,
+                               cascade[k].a1,
+                               cascade[k].a2 };
+        
+        gain *= static_cast<double>(cascade[k].b0);
+        residueSum += (r1 + r2).real();
+    }
+    
+    design.numSections = numSections;
+    design.direct = static_cast<float>(gain - residueSum);
+    return true;
+}
+
+ParallelDesign designParallelSections(const ChainSettings& chainSettings, double sampleRate)
+{
+    ParallelDesign design;
+    design.settings = chainSettings;
+    design.sampleRate = sampleRate;
+    
+    std::array<BiquadCoefficients, ParallelDesign::maxSections> cascade;
+    const auto numSections = makeCascadeSections(chainSettings, sampleRate, cascade);
+    
+    if (! expand(cascade, numSections, design))
+        return design;
+    
+    //Long enough for the lowest corner frequencies to ring out most of the way
+    constexpr int numSamples = 8192;
+    std::vector<float> seriesImpulse(numSamples, 0.0f), parallelImpulse(numSamples, 0.0f);
+    seriesImpulse[0] = parallelImpulse[0] = 1.0f;
+    
+    std::array<BiquadState, ParallelDesign::maxSections> seriesStates {}, parallelStates {};
+    auto* scalar = getScalarKernels();
+    scalar->processCascade(cascade.data(), seriesStates.data(), numSections, seriesImpulse.data(), numSamples);
+    scalar->processParallel(design.sections.data(), parallelStates.data(), numSections, design.direct,
+                            parallelImpulse.data(), numSamples);
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto error = std::abs(seriesImpulse[static_cast<size_t>(i)] - parallelImpulse[static_cast<size_t>(i)]);
+        
+        //Also catches NaNs and infinities from a badly conditioned expansion
+        if (! (error <= ParallelDesign::maxImpulseError))
+        {
+            design.impulseError = error;
+            return design;
+        }
+        
+        design.impulseError = juce::jmax(design.impulseError, error);
+    }
+    
+    design.valid = true;
+    return design;
+}
+
+//==============================================================================
+void ParallelFilter::reset()
+{
+    states.fill({});
+}
+
+void ParallelFilter::process(const ParallelDesign& design, float* samples, int numSamples)
+{
+    jassert(design.valid);
+    kernels->processParallel(design.sections.data(), states.data(), design.numSections, design.direct,
+                             samples, numSamples);
+}
+
+//==============================================================================
+ParallelDesigner::ParallelDesigner() : juce::Thread("myEQ parallel designer")
+{
+}
+
+ParallelDesigner::~ParallelDesigner()
+{
+    stop();
+}
+
+void ParallelDesigner::start()
+{
+    if (! isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+}
+
+void ParallelDesigner::stop()
+{
+    stopThread(1000);
+}
+
+void ParallelDesigner::requestDesign(const ChainSettings& chainSettings, double sampleRate)
+{
+    if (chainSettings == lastRequest.settings && sampleRate == lastRequest.sampleRate)
+        return;
+    
+    Request request { chainSettings, sampleRate };
+    
+    //If the designer is behind, the next block asks again
+    if (requests.push(request))
+        lastRequest = request;
+}
+
+bool ParallelDesigner::pullLatestDesign(ParallelDesign& design)
+{
+    bool pulled = false;
+    
+    while (designs.pull(design))
+        pulled = true;
+    
+    return pulled;
+}
+
+void ParallelDesigner::run()
+{
+    while (! threadShouldExit())
+    {
+        //Only the newest request matters, older ones would be out of date by the time they're done
+        Request request;
+        bool requested = false;
+        
+        while (requests.pull(request))
+            requested = true;
+        
+        if (requested)
+            designs.push(designParallelSections(request.settings, request.sampleRate));
+        
+        wait(10);
+    }
+}
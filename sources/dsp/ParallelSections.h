@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    The combined EQ response as a parallel sum of second order sections.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include "Fifo.h"
+#include "FilterChain.h"
+
+/** How the sections of the EQ are connected */
+enum class FilterTopology
+{
+    series,  //LowCut -> Peak -> HighCut, through KernelCascade
+    parallel //The partial fraction expansion of the whole chain, through ParallelFilter
+};
+
+bool operator==(const ChainSettings& a, const ChainSettings& b);
+bool operator!=(const ChainSettings& a, const ChainSettings& b);
+
+/**
+    The cascade of a ChainSettings rewritten as direct + sum of sections, each section
+    keeping a pole pair of the cascade with a first order numerator. Only usable if
+    valid, see designParallelSections().
+ */
+struct ParallelDesign
+{
+    static constexpr size_t maxSections = 9;
+    static constexpr float maxImpulseError = 1.0e-4f;
+    
+    std::array<BiquadCoefficients, maxSections> sections {};
+    int numSections = 0;
+    float direct = 1;
+    
+    ChainSettings settings;
+    double sampleRate = 0;
+    bool valid = false;
+    
+    //Largest difference with the cascade over the first samples of the impulse response
+    float impulseError = 0;
+};
+
+/** Collects the normalised sections of the cascade the settings describe, returns how many */
+int makeCascadeSections(const ChainSettings& chainSettings, double sampleRate,
+                        std::array<BiquadCoefficients, ParallelDesign::maxSections>& sections);
+
+/**
+    Expands the cascade into partial fractions in double precision, then runs the impulse
+    response of both forms through the scalar kernels. The design is only valid if the poles
+    are distinct enough for the expansion to exist and the two responses stay within
+    maxImpulseError: poles crowded around z = 1, like a steep low cut at a low frequency,
+    cancel catastrophically in single precision and are better left in series.
+    Allocates, don't call it on the audio thread.
+ */
+ParallelDesign designParallelSections(const ChainSettings& chainSettings, double sampleRate);
+
+/** Runs a ParallelDesign with the selected DspKernels, one instance per channel */
+class ParallelFilter
+{
+public:
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
+    void reset();
+    void process(const ParallelDesign& design, float* samples, int numSamples);
+    
+    bool hasSameState(const ParallelFilter& other) const { return statesEqual(states, other.states); }
+    void copyStateFrom(const ParallelFilter& other) { states = other.states; }
+    
+private:
+    std::array<BiquadState, ParallelDesign::maxSections> states;
+    const DspKernels* kernels = getScalarKernels();
+};
+
+/**
+    Designs on a background thread, so the audio thread only asks for the settings
+    it is playing and picks up the result a few milliseconds later. Both sides go
+    through lock-free Fifos.
+ */
+class ParallelDesigner : private juce::Thread
+{
+public:
+    ParallelDesigner();
+    ~ParallelDesigner() override;
+    
+    void start();
+    void stop();
+    
+    /** Audio thread: asks for a design if the settings changed since the last request */
+    void requestDesign(const ChainSettings& chainSettings, double sampleRate);
+    
+    /** Audio thread: replaces design with the newest one, returns false if there is none */
+    bool pullLatestDesign(ParallelDesign& design);
+    
+private:
+    struct Request
+    {
+        ChainSettings settings;
+        double sampleRate = 0;
+    };
+    
+    Fifo<Request> requests;
+    Fifo<ParallelDesign> designs;
+    Request lastRequest;
+    
+    void run() override;
+};
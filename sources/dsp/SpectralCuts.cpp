@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Low and high cuts of any steepness, applied in the frequency domain.
+
+  ==============================================================================
+*/
+
+#include "SpectralCuts.h"
+
+void SpectralCuts::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    
+    //The same resolution in Hz at every sample rate
+    const auto rateMultiple = juce::jmax(1, juce::roundToInt(sampleRate / 48000.0));
+    const auto order = 11 + juce::jlimit(0, 2, static_cast<int>(std::floor(std::log2(rateMultiple))));
+    
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    fftSize = fft->getSize();
+    hopSize = fftSize / 2;
+    
+    //Periodic, so the squares of overlapping halves add up to exactly 1
+    window.resize(static_cast<size_t>(fftSize));
+    for (int i = 0; i < fftSize; ++i)
+        window[static_cast<size_t>(i)] = std::sin(juce::MathConstants<float>::pi * static_cast<float>(i) / static_cast<float>(fftSize));
+    
+    mask.assign(static_cast<size_t>(fftSize / 2 + 1), 1.0f);
+    frame.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+    
+    for (auto& input : inputs)
+        input.assign(static_cast<size_t>(fftSize), 0.0f);
+    for (auto& output : outputs)
+        output.assign(static_cast<size_t>(fftSize), 0.0f);
+    
+    maskTransition = -1;
+    reset();
+}
+
+void SpectralCuts::reset()
+{
+    for (auto& input : inputs)
+        std::fill(input.begin(), input.end(), 0.0f);
+    for (auto& output : outputs)
+        std::fill(output.begin(), output.end(), 0.0f);
+    
+    hopPosition = 0;
+}
+
+void SpectralCuts::process(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, float transitionOctaves)
+{
+    jassert(fft != nullptr);
+    
+    updateMask(chainSettings, transitionOctaves);
+    
+    const auto numSamples = buffer.getNumSamples();
+    const auto channels = juce::jmin(numChannels, buffer.getNumChannels());
+    
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto length = juce::jmin(numSamples - offset, hopSize - hopPosition);
+        
+        //The new samples go at the end of the frame, and the output they replace is a hop old
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            auto* samples = buffer.getWritePointer(channel, offset);
+            auto& input = inputs[static_cast<size_t>(channel)];
+            auto& output = outputs[static_cast<size_t>(channel)];
+            
+            juce::FloatVectorOperations::copy(input.data() + hopSize + hopPosition, samples, length);
+            juce::FloatVectorOperations::copy(samples, output.data() + hopPosition, length);
+        }
+        
+        hopPosition += length;
+        offset += length;
+        
+        if (hopPosition == hopSize)
+        {
+            for (int channel = 0; channel < channels; ++channel)
+                processFrame(static_cast<size_t>(channel));
+            
+            hopPosition = 0;
+        }
+    }
+}
+
+void SpectralCuts::processFrame(size_t channel)
+{
+    auto& input = inputs[channel];
+    auto& output = outputs[channel];
+    const auto size = static_cast<size_t>(fftSize);
+    const auto hop = static_cast<size_t>(hopSize);
+    
+    juce::FloatVectorOperations::multiply(frame.data(), input.data(), window.data(), fftSize);
+    std::fill(frame.begin() + static_cast<std::ptrdiff_t>(size), frame.end(), 0.0f);
+    
+    //The full spectrum, so the mask is applied to both halves and the inverse comes out real
+    fft->performRealOnlyForwardTransform(frame.data());
+    
+    for (size_t bin = 0; bin < size; ++bin)
+    {
+        const auto gain = mask[bin <= size / 2 ? bin : size - bin];
+        frame[2 * bin] *= gain;
+        frame[2 * bin + 1] *= gain;
+    }
+    
+    fft->performRealOnlyInverseTransform(frame.data());
+    
+    //Shift both by a hop, then add the new frame where the output ends
+    std::copy(output.begin() + static_cast<std::ptrdiff_t>(hop), output.end(), output.begin());
+    std::fill(output.begin() + static_cast<std::ptrdiff_t>(size - hop), output.end(), 0.0f);
+    juce::FloatVectorOperations::multiply(frame.data(), window.data(), fftSize);
+    juce::FloatVectorOperations::add(output.data(), frame.data(), fftSize);
+    
+    std::copy(input.begin() + static_cast<std::ptrdiff_t>(hop), input.end(), input.begin());
+}
+
+void SpectralCuts::updateMask(const ChainSettings& chainSettings, float transitionOctaves)
+{
+    //Only the cuts matter, the slopes included, as the mask has its own
+    const auto unchanged = transitionOctaves == maskTransition
+                        && chainSettings.lowCutFreq == maskSettings.lowCutFreq
+                        && chainSettings.highCutFreq == maskSettings.highCutFreq
+                        && chainSettings.lowCutBypassed == maskSettings.lowCutBypassed
+                        && chainSettings.highCutBypassed == maskSettings.highCutBypassed;
+    if (unchanged)
+        return;
+    
+    maskSettings = chainSettings;
+    maskTransition = transitionOctaves;
+    
+    //0 below the transition, 1 above, a raised cosine over log frequency in between
+    auto ramp = [transitionOctaves](float octavesFromCut)
+    {
+        const auto position = juce::jlimit(0.0f, 1.0f, octavesFromCut / juce::jmax(transitionOctaves, 0.001f) + 0.5f);
+        return 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * position);
+    };
+    
+    const auto binWidth = static_cast<float>(sampleRate) / static_cast<float>(fftSize);
+    
+    for (size_t bin = 0; bin < mask.size(); ++bin)
+    {
+        auto gain = 1.0f;
+        
+        if (bin == 0)
+        {
+            //DC is below any low cut
+            gain = chainSettings.lowCutBypassed ? 1.0f : 0.0f;
+        }
+        else
+        {
+            const auto octaves = std::log2(static_cast<float>(bin) * binWidth);
+            
+            if (! chainSettings.lowCutBypassed)
+                gain *= ramp(octaves - std::log2(chainSettings.lowCutFreq));
+            if (! chainSettings.highCutBypassed)
+                gain *= ramp(std::log2(chainSettings.highCutFreq) - octaves);
+        }
+        
+        mask[bin] = gain;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    Low and high cuts of any steepness, applied in the frequency domain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "FilterChain.h"
+
+/**
+    The cuts of a ChainSettings as a short-time Fourier transform: frames of fftSize
+    samples every hop of half that, weighted by a square root Hann window before and after,
+    which overlap-adds back to the input when nothing is cut. Each bin is multiplied by a
+    mask that goes from 0 to 1 over transition octaves around the cut frequency in a
+    raised cosine. A narrow transition is as close to a brickwall as the bins allow, a
+    wider one rings less. The cost is two FFTs per hop and channel, whatever the slope.
+    A sample is only complete once the second frame it is in has been processed, so the
+    output is exactly one frame (two hops) late.
+ */
+class SpectralCuts
+{
+public:
+    static constexpr int numChannels = 2;
+    
+    /** Sizes the frames for the sample rate (2048 samples at 48 kHz) and resets, not on the audio thread */
+    void prepare(double sampleRate);
+    void reset();
+    
+    int getLatency() const { return fftSize; }
+    
+    /** Audio thread: replaces the first two channels with their cut versions, the cuts' slopes are ignored */
+    void process(juce::AudioBuffer<float>& buffer, const ChainSettings& chainSettings, float transitionOctaves);
+    
+private:
+    void updateMask(const ChainSettings& chainSettings, float transitionOctaves);
+    void processFrame(size_t channel);
+    
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int fftSize = 0, hopSize = 0;
+    double sampleRate = 44100.0;
+    
+    std::vector<float> window, mask, frame;
+    
+    //The last fftSize input samples, and the overlap-added output whose first hop is ready
+    std::array<std::vector<float>, numChannels> inputs, outputs;
+    int hopPosition = 0;
+    
+    ChainSettings maskSettings;
+    float maskTransition = -1;
+};
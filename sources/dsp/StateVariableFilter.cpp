@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    The EQ as a cascade of topology-preserving transform state variable filters.
+
+  ==============================================================================
+*/
+
+#include "StateVariableFilter.h"
+
+static float prewarp(double frequency, double sampleRate)
+{
+    //Just below Nyquist, where tan() heads off to infinity
+    auto f = juce::jmin(frequency, 0.499 * sampleRate);
+    return static_cast<float>(std::tan(juce::MathConstants<double>::pi * f / sampleRate));
+}
+
+SvfCoefficients makeSvfLowPass(double frequency, float quality, double sampleRate)
+{
+    SvfCoefficients c;
+    c.g = prewarp(frequency, sampleRate);
+    c.k = 1.0f / quality;
+    c.m0 = 0;
+    c.m1 = 0;
+    c.m2 = 1;
+    return c;
+}
+
+SvfCoefficients makeSvfHighPass(double frequency, float quality, double sampleRate)
+{
+    SvfCoefficients c;
+    c.g = prewarp(frequency, sampleRate);
+    c.k = 1.0f / quality;
+    c.m0 = 1;
+    c.m1 = -c.k;
+    c.m2 = -1;
+    return c;
+}
+
+//The same bell as juce::dsp::IIR::Coefficients::makePeakFilter, whose A is sqrt(gainFactor)
+SvfCoefficients makeSvfPeak(double frequency, float quality, float gainFactor, double sampleRate)
+{
+    const auto a = std::sqrt(gainFactor);
+    
+    SvfCoefficients c;
+    c.g = prewarp(frequency, sampleRate);
+    c.k = 1.0f / (quality * a);
+    c.m0 = 1;
+    c.m1 = c.k * (a * a - 1.0f);
+    c.m2 = 0;
+    return c;
+}
+
+//==============================================================================
+void SvfCascade::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+bool SvfCascade::hasSameState(const SvfCascade& other) const
+{
+    for (size_t i = 0; i < maxSections; ++i)
+    {
+        const auto& a = sections[i];
+        const auto& b = other.sections[i];
+        
+        if (a.active != b.active || a.state.ic1eq != b.state.ic1eq || a.state.ic2eq != b.state.ic2eq
+            || a.coefficients.g != b.coefficients.g || a.coefficients.k != b.coefficients.k
+            || a.coefficients.m0 != b.coefficients.m0 || a.coefficients.m1 != b.coefficients.m1
+            || a.coefficients.m2 != b.coefficients.m2)
+            return false;
+    }
+    
+    return true;
+}
+
+void SvfCascade::reset()
+{
+    for (auto& section : sections)
+    {
+        section.state = {};
+        section.active = false;
+    }
+}
+
+void SvfCascade::processSection(Section& section, const SvfCoefficients& target, float* samples, int numSamples)
+{
+    auto& c = section.coefficients;
+    auto& s = section.state;
+    
+    //A section that was bypassed starts at its new setting instead of gliding from a stale one,
+    //and from silence instead of the integrators it was left with
+    if (! section.active)
+    {
+        c = target;
+        s = {};
+    }
+    
+    section.active = true;
+    
+    auto ic1eq = s.ic1eq, ic2eq = s.ic2eq;
+    
+    const bool gliding = c.g != target.g || c.k != target.k
+                      || c.m0 != target.m0 || c.m1 != target.m1 || c.m2 != target.m2;
+    
+    if (! gliding || numSamples == 0)
+    {
+        const auto a1 = 1.0f / (1.0f + c.g * (c.g + c.k));
+        const auto a2 = c.g * a1;
+        const auto a3 = c.g * a2;
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto v0 = samples[i];
+            auto v3 = v0 - ic2eq;
+            auto v1 = a1 * ic1eq + a2 * v3;
+            auto v2 = ic2eq + a2 * ic1eq + a3 * v3;
+            ic1eq = 2.0f * v1 - ic1eq;
+            ic2eq = 2.0f * v2 - ic2eq;
+            samples[i] = c.m0 * v0 + c.m1 * v1 + c.m2 * v2;
+        }
+    }
+    else
+    {
+        //Only g and k feed back, so the division is the only real cost of gliding
+        const auto step = 1.0f / static_cast<float>(numSamples);
+        const SvfCoefficients delta { (target.g - c.g) * step, (target.k - c.k) * step,
+                                      (target.m0 - c.m0) * step, (target.m1 - c.m1) * step, (target.m2 - c.m2) * step };
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto t = static_cast<float>(i + 1);
+            const auto g = c.g + delta.g * t;
+            const auto k = c.k + delta.k * t;
+            
+            const auto a1 = 1.0f / (1.0f + g * (g + k));
+            const auto a2 = g * a1;
+            const auto a3 = g * a2;
+            
+            auto v0 = samples[i];
+            auto v3 = v0 - ic2eq;
+            auto v1 = a1 * ic1eq + a2 * v3;
+            auto v2 = ic2eq + a2 * ic1eq + a3 * v3;
+            ic1eq = 2.0f * v1 - ic1eq;
+            ic2eq = 2.0f * v2 - ic2eq;
+            samples[i] = (c.m0 + delta.m0 * t) * v0 + (c.m1 + delta.m1 * t) * v1 + (c.m2 + delta.m2 * t) * v2;
+        }
+        
+        c = target;
+    }
+    
+    juce::dsp::util::snapToZero(ic1eq);
+    juce::dsp::util::snapToZero(ic2eq);
+    s.ic1eq = ic1eq;
+    s.ic2eq = ic2eq;
+}
+
+void SvfCascade::process(const ChainSettings& chainSettings, float* samples, int numSamples)
+{
+    auto processCut = [&](bool highPass, float frequency, Slope slope, size_t firstSection)
+    {
+        const auto order = 2 * (slope + 1);
+        
+        for (int i = 0; i < order / 2; ++i)
+        {
+            const auto quality = getButterworthQuality(i, order);
+            const auto target = highPass ? makeSvfHighPass(frequency, quality, sampleRate)
+                                         : makeSvfLowPass(frequency, quality, sampleRate);
+            processSection(sections[firstSection + static_cast<size_t>(i)], target, samples, numSamples);
+        }
+        
+        //Sections the slope doesn't use are bypassed
+        for (auto i = static_cast<size_t>(order / 2); i < 4; ++i)
+            sections[firstSection + i].active = false;
+    };
+    
+    if (! chainSettings.lowCutBypassed)
+        processCut(true, chainSettings.lowCutFreq, chainSettings.lowCutSlope, 0);
+    else
+        for (size_t i = 0; i < 4; ++i)
+            sections[i].active = false;
+    
+    if (! chainSettings.peakBypassed)
+        processSection(sections[4],
+                       makeSvfPeak(chainSettings.peakFreq, chainSettings.peakQuality,
+                                   juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels), sampleRate),
+                       samples, numSamples);
+    else
+        sections[4].active = false;
+    
+    if (! chainSettings.highCutBypassed)
+        processCut(false, chainSettings.highCutFreq, chainSettings.highCutSlope, 5);
+    else
+        for (size_t i = 5; i < maxSections; ++i)
+            sections[i].active = false;
+}
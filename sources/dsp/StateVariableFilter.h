@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    The EQ as a cascade of topology-preserving transform state variable filters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include "FilterChain.h"
+
+/**
+    One TPT state variable filter section, as in Andrew Simper's "Linear Trap Optimised"
+    SVF. g = tan(pi f / fs) sets the frequency and k = 1 / Q the damping, the output mixes
+    the input, band pass and low pass: m0 v0 + m1 v1 + m2 v2. Any positive g and k is
+    stable, so these can be interpolated directly.
+ */
+struct SvfCoefficients
+{
+    float g = 0, k = 2;
+    float m0 = 1, m1 = 0, m2 = 0; //Passes the input through
+};
+
+struct SvfState
+{
+    float ic1eq = 0, ic2eq = 0;
+};
+
+SvfCoefficients makeSvfLowPass(double frequency, float quality, double sampleRate);
+SvfCoefficients makeSvfHighPass(double frequency, float quality, double sampleRate);
+SvfCoefficients makeSvfPeak(double frequency, float quality, float gainFactor, double sampleRate);
+
+/**
+    The same sections as MonoChain (the responses match to within coefficient rounding),
+    designed straight from the ChainSettings on every block. A design is one tan() per
+    band rather than a set of biquads, and the coefficients glide linearly from the last
+    block's to the new ones sample by sample, so fast modulation doesn't zipper or blow up.
+    A section that comes back from bypass, or that a steeper slope brings in, starts from
+    silence rather than from the state it was left with, which would click.
+ */
+class SvfCascade
+{
+public:
+    void prepare(double newSampleRate);
+    void reset();
+    void process(const ChainSettings& chainSettings, float* samples, int numSamples);
+    
+    /** For dual mono, see KernelCascade. The gliding coefficients count as state here. */
+    bool hasSameState(const SvfCascade& other) const;
+    void copyStateFrom(const SvfCascade& other) { sections = other.sections; }
+    
+private:
+    //Same positions as KernelCascade: four low cut sections, the peak, four high cut sections
+    static constexpr size_t maxSections = 9;
+    
+    struct Section
+    {
+        SvfCoefficients coefficients;
+        SvfState state;
+        bool active = false;
+    };
+    
+    std::array<Section, maxSections> sections;
+    double sampleRate = 44100.0;
+    
+    static void processSection(Section& section, const SvfCoefficients& target, float* samples, int numSamples);
+};
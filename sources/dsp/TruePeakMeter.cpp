@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    ITU-R BS.1770 true-peak metering of the output.
+
+  ==============================================================================
+*/
+
+#include "TruePeakMeter.h"
+
+void TruePeakMeter::reset()
+{
+    for (auto& channel : history)
+        channel.fill(0);
+    
+    wasEnabled = false;
+}
+
+void TruePeakMeter::measure(const juce::AudioBuffer<float>& buffer, bool enabled)
+{
+    if (! enabled)
+    {
+        wasEnabled = false;
+        return;
+    }
+    
+    //Whatever the history held is from before the meter was switched off
+    if (! wasEnabled)
+        for (auto& channel : history)
+            std::fill(channel.begin(), channel.begin() + truePeakHistory, 0.0f);
+    
+    wasEnabled = true;
+    
+    const auto numSamples = buffer.getNumSamples();
+    
+    for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); ++channel)
+    {
+        auto& samples = history[static_cast<size_t>(channel)];
+        const auto* input = buffer.getReadPointer(channel);
+        float peak = 0;
+        
+        for (int offset = 0; offset < numSamples; offset += chunkSize)
+        {
+            const auto length = juce::jmin(chunkSize, numSamples - offset);
+            std::copy(input + offset, input + offset + length, samples.begin() + truePeakHistory);
+            
+            peak = juce::jmax(peak, kernels->measureTruePeak(samples.data() + truePeakHistory, length));
+            
+            //The end of this chunk becomes the history of the next
+            std::copy(samples.begin() + length, samples.begin() + length + truePeakHistory, samples.begin());
+        }
+        
+        auto& held = peaks[static_cast<size_t>(channel)];
+        auto current = held.load(std::memory_order_relaxed);
+        while (peak > current && ! held.compare_exchange_weak(current, peak, std::memory_order_relaxed))
+            ;
+    }
+}
+
+float TruePeakMeter::take(int channel)
+{
+    jassert(channel >= 0 && channel < numChannels);
+    return peaks[static_cast<size_t>(channel)].exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    ITU-R BS.1770 true-peak metering of the output.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include "DspKernels.h"
+
+/**
+    Measures the inter-sample peaks of the first two channels with
+    DspKernels::measureTruePeak(). The polyphase interpolator only computes the four
+    phases at the input rate, never the 4x signal itself. Off by default, when it costs
+    nothing; the peak is held until the editor takes it, like LevelMeter's.
+ */
+class TruePeakMeter
+{
+public:
+    static constexpr int numChannels = 2;
+    
+    void setKernels(const DspKernels& newKernels) { kernels = &newKernels; }
+    
+    /** Clears the interpolator's history, not on the audio thread */
+    void reset();
+    
+    /** Audio thread, does nothing unless enabled */
+    void measure(const juce::AudioBuffer<float>& buffer, bool enabled);
+    
+    /** Any thread: the largest true peak since the last call, as a gain */
+    float take(int channel);
+    
+private:
+    //Blocks are measured in chunks behind the history of the previous one
+    static constexpr int chunkSize = 256;
+    
+    std::array<std::array<float, truePeakHistory + chunkSize>, numChannels> history {};
+    std::array<std::atomic<float>, numChannels> peaks {};
+    bool wasEnabled = false;
+    const DspKernels* kernels = getScalarKernels();
+};
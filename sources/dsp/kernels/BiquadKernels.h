@@ -0,0 +1,687 @@
+/*
+  ==============================================================================
+
+    The kernel bodies shared by every instruction set variant.
+
+    Only include this from the Kernels<variant>.cpp files. Everything here has
+    internal linkage and the templates are instantiated with a vector traits
+    struct from an anonymous namespace, so each variant gets its own copy and
+    nothing compiled for one instruction set can be picked by the linker for
+    another.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../DspKernels.h"
+#include <math.h> //Not <cmath>: its inline overloads would be shared between the variants
+
+static inline void snapToZero(float& value)
+{
+    //Same threshold as JUCE_SNAP_TO_ZERO
+    if (! (value < -1.0e-8f || value > 1.0e-8f))
+        value = 0;
+}
+
+//The same loop as juce::dsp::IIR::Filter::processSamples() for a second order filter
+static inline void processSection(const BiquadCoefficients& c, BiquadState& state, float* samples, int numSamples)
+{
+    auto lv1 = state.s1;
+    auto lv2 = state.s2;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto input = samples[i];
+        auto output = input * c.b0 + lv1;
+        samples[i] = output;
+        lv1 = (input * c.b1) - (output * c.a1) + lv2;
+        lv2 = (input * c.b2) - (output * c.a2);
+    }
+    
+    snapToZero(lv1);
+    snapToZero(lv2);
+    state.s1 = lv1;
+    state.s2 = lv2;
+}
+
+static inline void processCascadeScalar(const BiquadCoefficients* coefficients,
+                                        BiquadState* states,
+                                        int numSections,
+                                        float* samples,
+                                        int numSamples)
+{
+    for (int i = 0; i < numSections; ++i)
+        processSection(coefficients[i], states[i], samples, numSamples);
+}
+
+static inline void gainToDecibelsScalar(float* values, int numValues, float minusInfinityDb)
+{
+    for (int i = 0; i < numValues; ++i)
+    {
+        auto gain = values[i];
+        auto db = gain > 0 ? log10f(gain) * 20.0f : minusInfinityDb;
+        values[i] = db > minusInfinityDb ? db : minusInfinityDb;
+    }
+}
+
+//==============================================================================
+/*
+    The cascade is serial in time, so instead of running the sections one after another,
+    lane k of the vector runs section k, one sample behind lane k - 1. Each step shifts the
+    previous outputs up one lane and feeds the next input into lane 0, so a chunk of m
+    sections produces one output per step after m - 1 steps of latency. Per lane the
+    arithmetic is exactly processSection()'s.
+ */
+template<typename V, bool someLanesIdle>
+static inline void cascadeStep(typename V::Type& y,
+                               typename V::Type& s1,
+                               typename V::Type& s2,
+                               const typename V::Type (&c)[5],
+                               typename V::Type lanes,
+                               float input,
+                               int step,
+                               int numSamples)
+{
+    auto x = V::shiftIn(y, input);
+    y = V::add(V::mul(x, c[0]), s1);
+    auto newS1 = V::add(V::sub(V::mul(x, c[1]), V::mul(y, c[3])), s2);
+    auto newS2 = V::sub(V::mul(x, c[2]), V::mul(y, c[4]));
+    
+    if constexpr (someLanesIdle)
+    {
+        //Lane k works on sample step - k, which has to be inside this block
+        auto active = V::lanesBetween(lanes,
+                                      static_cast<float>(step - numSamples + 1),
+                                      static_cast<float>(step));
+        s1 = V::select(active, newS1, s1);
+        s2 = V::select(active, newS2, s2);
+    }
+    else
+    {
+        s1 = newS1;
+        s2 = newS2;
+    }
+}
+
+template<typename V>
+static void processCascadeChunk(const BiquadCoefficients* coefficients,
+                                BiquadState* states,
+                                int numSections,
+                                float* samples,
+                                int numSamples)
+{
+    constexpr int width = V::width;
+    alignas(64) float scratch[7][width] = {};
+    
+    for (int k = 0; k < numSections; ++k)
+    {
+        scratch[0][k] = coefficients[k].b0;
+        scratch[1][k] = coefficients[k].b1;
+        scratch[2][k] = coefficients[k].b2;
+        scratch[3][k] = coefficients[k].a1;
+        scratch[4][k] = coefficients[k].a2;
+        scratch[5][k] = states[k].s1;
+        scratch[6][k] = states[k].s2;
+    }
+    
+    const typename V::Type c[5] { V::load(scratch[0]), V::load(scratch[1]), V::load(scratch[2]),
+                                  V::load(scratch[3]), V::load(scratch[4]) };
+    auto s1 = V::load(scratch[5]);
+    auto s2 = V::load(scratch[6]);
+    auto y = V::broadcast(0);
+    const auto lanes = V::laneIndices();
+    
+    const int latency = numSections - 1;
+    const int numSteps = numSamples + latency;
+    const int firstFullStep = latency < numSamples ? latency : numSamples;
+    const int endOfFullSteps = numSamples;
+    auto& output = scratch[0];
+    
+    int step = 0;
+    
+    for (; step < firstFullStep; ++step)
+    {
+        cascadeStep<V, true>(y, s1, s2, c, lanes, samples[step], step, numSamples);
+    }
+    
+    for (; step < endOfFullSteps; ++step)
+    {
+        cascadeStep<V, false>(y, s1, s2, c, lanes, samples[step], step, numSamples);
+        V::store(output, y);
+        samples[step - latency] = output[latency];
+    }
+    
+    for (; step < numSteps; ++step)
+    {
+        cascadeStep<V, true>(y, s1, s2, c, lanes, 0.0f, step, numSamples);
+        
+        if (step >= latency)
+        {
+            V::store(output, y);
+            samples[step - latency] = output[latency];
+        }
+    }
+    
+    V::store(scratch[5], s1);
+    V::store(scratch[6], s2);
+    
+    for (int k = 0; k < numSections; ++k)
+    {
+        states[k].s1 = scratch[5][k];
+        states[k].s2 = scratch[6][k];
+        snapToZero(states[k].s1);
+        snapToZero(states[k].s2);
+    }
+}
+
+template<typename V>
+static void processCascade(const BiquadCoefficients* coefficients,
+                           BiquadState* states,
+                           int numSections,
+                           float* samples,
+                           int numSamples)
+{
+    while (numSections > 0)
+    {
+        const int chunk = numSections < V::width ? numSections : V::width;
+        
+        if (chunk == 1)
+            processSection(*coefficients, *states, samples, numSamples);
+        else
+            processCascadeChunk<V>(coefficients, states, chunk, samples, numSamples);
+        
+        coefficients += chunk;
+        states += chunk;
+        numSections -= chunk;
+    }
+}
+
+//==============================================================================
+static inline bool sameCoefficients(const BiquadCoefficients& a, const BiquadCoefficients& b)
+{
+    return a.b0 == b.b0 && a.b1 == b.b1 && a.b2 == b.b2 && a.a1 == b.a1 && a.a2 == b.a2;
+}
+
+/*
+    Block state-space form of one section: for a block of L = V::width samples u, the output is
+
+        y = H u + s1 p + s2 q
+
+    where H is the lower triangular Toeplitz matrix of the first L samples of the impulse
+    response, p is the response to a unit s1 with no input and q, the response to a unit s2,
+    is p delayed by one sample. The state at the end of the block is
+
+        s' = A s + f
+
+    where A is the state transition over L samples and f the state the block's input leaves
+    behind from a zero state. Only those two scalar multiply-adds depend on the previous block,
+    everything else is computed across the lanes. H, p, q and A only depend on the coefficients,
+    so they are kept in a BlockedSection until those change.
+ */
+template<typename V>
+static void buildBlockedSection(const BiquadCoefficients& c, BlockedSection& blocked)
+{
+    constexpr int width = V::width;
+    static_assert(width <= BlockedSection::maxWidth, "BlockedSection is too narrow for this vector");
+    
+    float impulse[width];
+    float h1 = 0, h2 = 0, p1 = 1, p2 = 0;
+    for (int i = 0; i < width; ++i)
+    {
+        const float x = i == 0 ? 1.0f : 0.0f;
+        auto y = x * c.b0 + h1;
+        h1 = (x * c.b1) - (y * c.a1) + h2;
+        h2 = (x * c.b2) - (y * c.a2);
+        impulse[i] = y;
+        
+        auto z = p1;
+        p1 = -(z * c.a1) + p2;
+        p2 = -(z * c.a2);
+        blocked.zeroInputS1[i] = z;
+        blocked.zeroInputS2[i] = i == 0 ? 0.0f : blocked.zeroInputS1[i - 1];
+    }
+    
+    //Column j of H is the impulse response delayed by j samples
+    for (int j = 0; j < width; ++j)
+        for (int i = 0; i < width; ++i)
+            blocked.columns[j][i] = i < j ? 0.0f : impulse[i - j];
+    
+    //A, from the last two outputs of the zero-input responses
+    const auto last = width - 1;
+    blocked.a11 = -(blocked.zeroInputS1[last] * c.a1) - (blocked.zeroInputS1[last - 1] * c.a2);
+    blocked.a12 = -(blocked.zeroInputS2[last] * c.a1) - (blocked.zeroInputS2[last - 1] * c.a2);
+    blocked.a21 = -(blocked.zeroInputS1[last] * c.a2);
+    blocked.a22 = -(blocked.zeroInputS2[last] * c.a2);
+    
+    blocked.coefficients = c;
+    blocked.width = width;
+}
+
+template<typename V>
+static void processSectionBlocked(const BiquadCoefficients& c, BlockedSection& blocked, BiquadState& state,
+                                  float* samples, int numSamples)
+{
+    constexpr int width = V::width;
+    const auto built = blocked.width == width && sameCoefficients(blocked.coefficients, c);
+    
+    //Building H costs about as much as a few blocks of samples, so it isn't worth it for a
+    //short run of samples with coefficients that may change again before the next
+    if (numSamples < width || (! built && numSamples < 4 * width))
+    {
+        processSection(c, state, samples, numSamples);
+        return;
+    }
+    
+    if (! built)
+        buildBlockedSection<V>(c, blocked);
+    
+    typename V::Type columns[width];
+    for (int j = 0; j < width; ++j)
+        columns[j] = V::load(blocked.columns[j]);
+    
+    const auto p = V::load(blocked.zeroInputS1);
+    const auto q = V::load(blocked.zeroInputS2);
+    const auto last = width - 1;
+    
+    alignas(64) float forced[width];
+    auto s1 = state.s1;
+    auto s2 = state.s2;
+    int i = 0;
+    
+    for (; i + width <= numSamples; i += width)
+    {
+        auto* block = samples + i;
+        const auto uLast = block[last];
+        const auto uBeforeLast = block[last - 1];
+        
+        //Two partial sums, so the adds don't form one long dependency chain
+        auto even = V::mul(V::broadcast(block[0]), columns[0]);
+        auto odd = V::mul(V::broadcast(block[1]), columns[1]);
+        for (int j = 2; j < width; j += 2)
+        {
+            even = V::add(even, V::mul(V::broadcast(block[j]), columns[j]));
+            odd = V::add(odd, V::mul(V::broadcast(block[j + 1]), columns[j + 1]));
+        }
+        
+        const auto zeroState = V::add(even, odd);
+        V::storeUnaligned(block, V::add(zeroState, V::add(V::mul(V::broadcast(s1), p), V::mul(V::broadcast(s2), q))));
+        
+        V::store(forced, zeroState);
+        const auto f1 = (uLast * c.b1) - (forced[last] * c.a1) + ((uBeforeLast * c.b2) - (forced[last - 1] * c.a2));
+        const auto f2 = (uLast * c.b2) - (forced[last] * c.a2);
+        
+        const auto nextS1 = blocked.a11 * s1 + blocked.a12 * s2 + f1;
+        s2 = blocked.a21 * s1 + blocked.a22 * s2 + f2;
+        s1 = nextS1;
+    }
+    
+    //The remainder runs through the recursion, which also snaps the state to zero
+    state = { s1, s2 };
+    processSection(c, state, samples + i, numSamples - i);
+}
+
+template<typename V>
+static void processCascadeBlocked(const BiquadCoefficients* coefficients,
+                                  BlockedSection* blocked,
+                                  BiquadState* states,
+                                  int numSections,
+                                  float* samples,
+                                  int numSamples)
+{
+    for (int i = 0; i < numSections; ++i)
+        processSectionBlocked<V>(coefficients[i], blocked[i], states[i], samples, numSamples);
+}
+
+//==============================================================================
+//The parallel form: every section gets the same input and their outputs are summed
+static inline void processParallelScalar(const BiquadCoefficients* coefficients,
+                                         BiquadState* states,
+                                         int numSections,
+                                         float direct,
+                                         float* samples,
+                                         int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto input = samples[i];
+        auto sum = input * direct;
+        
+        for (int k = 0; k < numSections; ++k)
+        {
+            auto& c = coefficients[k];
+            auto& state = states[k];
+            auto output = input * c.b0 + state.s1;
+            state.s1 = (input * c.b1 + state.s2) - (output * c.a1);
+            state.s2 = (input * c.b2) - (output * c.a2);
+            sum += output;
+        }
+        
+        samples[i] = sum;
+    }
+    
+    for (int k = 0; k < numSections; ++k)
+    {
+        snapToZero(states[k].s1);
+        snapToZero(states[k].s2);
+    }
+}
+
+/*
+    The sections are independent, so here they simply go across the lanes, in NumChunks
+    vectors. Unlike the cascade there is no dependency between the lanes within a sample,
+    only the horizontal sum at the end of it. The state update adds the input terms first,
+    so the recursion through s1 is one add, one multiply and one subtract long.
+ */
+template<typename V, int NumChunks>
+static void processParallelChunks(const BiquadCoefficients* coefficients,
+                                  BiquadState* states,
+                                  int numSections,
+                                  float direct,
+                                  float* samples,
+                                  int numSamples)
+{
+    constexpr int width = V::width;
+    
+    alignas(64) float scratch[NumChunks][7][width] = {};
+    typename V::Type c[NumChunks][5], s1[NumChunks], s2[NumChunks];
+    
+    for (int k = 0; k < numSections; ++k)
+    {
+        auto& lanes = scratch[k / width];
+        lanes[0][k % width] = coefficients[k].b0;
+        lanes[1][k % width] = coefficients[k].b1;
+        lanes[2][k % width] = coefficients[k].b2;
+        lanes[3][k % width] = coefficients[k].a1;
+        lanes[4][k % width] = coefficients[k].a2;
+        lanes[5][k % width] = states[k].s1;
+        lanes[6][k % width] = states[k].s2;
+    }
+    
+    for (int chunk = 0; chunk < NumChunks; ++chunk)
+    {
+        for (int i = 0; i < 5; ++i)
+            c[chunk][i] = V::load(scratch[chunk][i]);
+        
+        s1[chunk] = V::load(scratch[chunk][5]);
+        s2[chunk] = V::load(scratch[chunk][6]);
+    }
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto x = V::broadcast(samples[i]);
+        auto sum = V::broadcast(0);
+        
+        for (int chunk = 0; chunk < NumChunks; ++chunk)
+        {
+            auto y = V::add(V::mul(x, c[chunk][0]), s1[chunk]);
+            s1[chunk] = V::sub(V::add(V::mul(x, c[chunk][1]), s2[chunk]), V::mul(y, c[chunk][3]));
+            s2[chunk] = V::sub(V::mul(x, c[chunk][2]), V::mul(y, c[chunk][4]));
+            sum = V::add(sum, y);
+        }
+        
+        samples[i] = samples[i] * direct + V::sum(sum);
+    }
+    
+    for (int chunk = 0; chunk < NumChunks; ++chunk)
+    {
+        V::store(scratch[chunk][5], s1[chunk]);
+        V::store(scratch[chunk][6], s2[chunk]);
+    }
+    
+    for (int k = 0; k < numSections; ++k)
+    {
+        states[k].s1 = scratch[k / width][5][k % width];
+        states[k].s2 = scratch[k / width][6][k % width];
+        snapToZero(states[k].s1);
+        snapToZero(states[k].s2);
+    }
+}
+
+template<typename V>
+static void processParallel(const BiquadCoefficients* coefficients,
+                            BiquadState* states,
+                            int numSections,
+                            float direct,
+                            float* samples,
+                            int numSamples)
+{
+    switch ((numSections + V::width - 1) / V::width)
+    {
+        case 0:
+        case 1: processParallelChunks<V, 1>(coefficients, states, numSections, direct, samples, numSamples); break;
+        case 2: processParallelChunks<V, 2>(coefficients, states, numSections, direct, samples, numSamples); break;
+        case 3: processParallelChunks<V, 3>(coefficients, states, numSections, direct, samples, numSamples); break;
+        default: processParallelScalar(coefficients, states, numSections, direct, samples, numSamples); break;
+    }
+}
+
+//==============================================================================
+//Natural logarithm after Cephes' logf(), accurate to a couple of ulps for positive normal input
+template<typename V>
+static inline typename V::Type logPolynomial(typename V::Type x)
+{
+    typename V::Type m, e;
+    V::splitExponent(x, m, e);
+    
+    const auto one = V::broadcast(1.0f);
+    const auto zero = V::broadcast(0.0f);
+    const auto belowSqrtHalf = V::lessThan(m, V::broadcast(0.707106781186547524f));
+    e = V::sub(e, V::select(belowSqrtHalf, one, zero));
+    m = V::sub(V::add(m, V::select(belowSqrtHalf, m, zero)), one);
+    
+    const auto z = V::mul(m, m);
+    auto p = V::broadcast(7.0376836292e-2f);
+    p = V::add(V::mul(p, m), V::broadcast(-1.1514610310e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(1.1676998740e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(-1.2420140846e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(1.4249322787e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(-1.6668057665e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(2.0000714765e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(-2.4999993993e-1f));
+    p = V::add(V::mul(p, m), V::broadcast(3.3333331174e-1f));
+    
+    auto r = V::mul(V::mul(p, m), z);
+    r = V::add(r, V::mul(e, V::broadcast(-2.12194440e-4f)));
+    r = V::sub(r, V::mul(z, V::broadcast(0.5f)));
+    
+    return V::add(V::add(m, r), V::mul(e, V::broadcast(0.693359375f)));
+}
+
+template<typename V>
+static void gainToDecibels(float* values, int numValues, float minusInfinityDb)
+{
+    const auto floor = V::broadcast(minusInfinityDb);
+    const auto smallestNormal = V::broadcast(1.17549435e-38f);
+    const auto decibelsPerNeper = V::broadcast(8.68588963806503655f);
+    
+    int i = 0;
+    for (; i + V::width <= numValues; i += V::width)
+    {
+        auto gain = V::loadUnaligned(values + i);
+        
+        //Anything below the smallest normal float is well under any useful minusInfinityDb,
+        //and this also catches zero, negative and NaN input like gainToDecibels() does
+        auto db = V::select(V::atLeast(gain, smallestNormal),
+                            V::max(floor, V::mul(logPolynomial<V>(gain), decibelsPerNeper)),
+                            floor);
+        V::storeUnaligned(values + i, db);
+    }
+    
+    gainToDecibelsScalar(values + i, numValues - i, minusInfinityDb);
+}
+
+//==============================================================================
+template<bool copy>
+static inline LevelMeasurement measureLevelScalar(const float* samples, int numSamples, float* copyTo)
+{
+    LevelMeasurement level;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto x = samples[i];
+        const auto magnitude = fabsf(x);
+        level.peak = magnitude > level.peak ? magnitude : level.peak;
+        level.sumOfSquares += x * x;
+        
+        if (copy)
+            copyTo[i] = x;
+    }
+    
+    return level;
+}
+
+static inline LevelMeasurement measureLevelScalar(const float* samples, int numSamples, float* copyTo)
+{
+    return copyTo != nullptr ? measureLevelScalar<true>(samples, numSamples, copyTo)
+                             : measureLevelScalar<false>(samples, numSamples, copyTo);
+}
+
+//Two accumulators each, so consecutive additions don't wait on one another
+template<typename V, bool copy>
+static LevelMeasurement measureLevel(const float* samples, int numSamples, float* copyTo)
+{
+    const auto zero = V::broadcast(0.0f);
+    auto peak0 = zero, peak1 = zero, sum0 = zero, sum1 = zero;
+    
+    int i = 0;
+    for (; i + 2 * V::width <= numSamples; i += 2 * V::width)
+    {
+        const auto x0 = V::loadUnaligned(samples + i);
+        const auto x1 = V::loadUnaligned(samples + i + V::width);
+        peak0 = V::max(peak0, V::max(x0, V::sub(zero, x0)));
+        peak1 = V::max(peak1, V::max(x1, V::sub(zero, x1)));
+        sum0 = V::add(sum0, V::mul(x0, x0));
+        sum1 = V::add(sum1, V::mul(x1, x1));
+        
+        if (copy)
+        {
+            V::storeUnaligned(copyTo + i, x0);
+            V::storeUnaligned(copyTo + i + V::width, x1);
+        }
+    }
+    
+    auto level = measureLevelScalar<copy>(samples + i, numSamples - i, copy ? copyTo + i : nullptr);
+    
+    float lanes[V::width];
+    V::storeUnaligned(lanes, V::max(peak0, peak1));
+    for (auto lane : lanes)
+        level.peak = lane > level.peak ? lane : level.peak;
+    
+    level.sumOfSquares += V::sum(V::add(sum0, sum1));
+    return level;
+}
+
+template<typename V>
+static LevelMeasurement measureLevel(const float* samples, int numSamples, float* copyTo)
+{
+    return copyTo != nullptr ? measureLevel<V, true>(samples, numSamples, copyTo)
+                             : measureLevel<V, false>(samples, numSamples, copyTo);
+}
+
+//==============================================================================
+//The 48 tap interpolator of ITU-R BS.1770-4, Annex 2, split into its four phases
+static const float truePeakPhases[4][truePeakHistory + 1]
+{
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+       0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+       0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+       0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+       0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+static inline float measureTruePeakScalar(const float* samples, int numSamples)
+{
+    float peak = 0;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (const auto& phase : truePeakPhases)
+        {
+            float y = 0;
+            for (int k = 0; k <= truePeakHistory; ++k)
+                y += phase[k] * samples[i - k];
+            
+            const auto magnitude = fabsf(y);
+            peak = magnitude > peak ? magnitude : peak;
+        }
+    }
+    
+    return peak;
+}
+
+/*
+    A vector's width of consecutive outputs at a time. Each tap is one shifted unaligned
+    load shared by the four phases, which accumulate independently of one another.
+ */
+template<typename V>
+static float measureTruePeak(const float* samples, int numSamples)
+{
+    const auto zero = V::broadcast(0.0f);
+    auto peak = zero;
+    
+    //Broadcast once per call: there are more taps than registers, and reloading a vector is cheaper
+    typename V::Type taps[truePeakHistory + 1][4];
+    for (int k = 0; k <= truePeakHistory; ++k)
+        for (int p = 0; p < 4; ++p)
+            taps[k][p] = V::broadcast(truePeakPhases[p][k]);
+    
+    int i = 0;
+    for (; i + V::width <= numSamples; i += V::width)
+    {
+        auto y0 = zero, y1 = zero, y2 = zero, y3 = zero;
+        
+        for (int k = 0; k <= truePeakHistory; ++k)
+        {
+            const auto x = V::loadUnaligned(samples + i - k);
+            y0 = V::add(y0, V::mul(taps[k][0], x));
+            y1 = V::add(y1, V::mul(taps[k][1], x));
+            y2 = V::add(y2, V::mul(taps[k][2], x));
+            y3 = V::add(y3, V::mul(taps[k][3], x));
+        }
+        
+        peak = V::max(peak, V::max(V::max(y0, V::sub(zero, y0)), V::max(y1, V::sub(zero, y1))));
+        peak = V::max(peak, V::max(V::max(y2, V::sub(zero, y2)), V::max(y3, V::sub(zero, y3))));
+    }
+    
+    auto result = measureTruePeakScalar(samples + i, numSamples - i);
+    
+    float lanes[V::width];
+    V::storeUnaligned(lanes, peak);
+    for (auto lane : lanes)
+        result = lane > result ? lane : result;
+    
+    return result;
+}
+
+//==============================================================================
+static inline void matrixMidSideScalar(float* first, float* second, int numSamples, float scale)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto a = first[i];
+        const auto b = second[i];
+        first[i] = (a + b) * scale;
+        second[i] = (a - b) * scale;
+    }
+}
+
+template<typename V>
+static void matrixMidSide(float* first, float* second, int numSamples, float scale)
+{
+    const auto gain = V::broadcast(scale);
+    
+    int i = 0;
+    for (; i + V::width <= numSamples; i += V::width)
+    {
+        const auto a = V::loadUnaligned(first + i);
+        const auto b = V::loadUnaligned(second + i);
+        V::storeUnaligned(first + i, V::mul(V::add(a, b), gain));
+        V::storeUnaligned(second + i, V::mul(V::sub(a, b), gain));
+    }
+    
+    matrixMidSideScalar(first + i, second + i, numSamples - i, scale);
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    AVX2 variant of the DSP kernels, see BiquadKernels.h.
+
+  ==============================================================================
+*/
+
+#include "../DspKernels.h"
+
+#if defined(__AVX2__)
+
+#include "BiquadKernels.h"
+#include <immintrin.h>
+
+namespace
+{
+struct AVX2
+{
+    using Type = __m256;
+    using Mask = __m256;
+    static constexpr int width = 8;
+    
+    static Type load(const float* p) { return _mm256_load_ps(p); }
+    static Type loadUnaligned(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Type v) { _mm256_store_ps(p, v); }
+    static void storeUnaligned(float* p, Type v) { _mm256_storeu_ps(p, v); }
+    static Type broadcast(float v) { return _mm256_set1_ps(v); }
+    
+    static Type add(Type a, Type b) { return _mm256_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+    static Type max(Type a, Type b) { return _mm256_max_ps(a, b); }
+    
+    static Mask lessThan(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Mask atLeast(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Type select(Mask m, Type a, Type b) { return _mm256_blendv_ps(b, a, m); }
+    
+    static float sum(Type v)
+    {
+        auto quads = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        auto pairs = _mm_add_ps(quads, _mm_movehl_ps(quads, quads));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    
+    static Type laneIndices() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+    
+    static Mask lanesBetween(Type lanes, float first, float last)
+    {
+        return _mm256_and_ps(_mm256_cmp_ps(lanes, _mm256_set1_ps(first), _CMP_GE_OQ),
+                             _mm256_cmp_ps(lanes, _mm256_set1_ps(last), _CMP_LE_OQ));
+    }
+    
+    //{ x, y0, y1, ..., y6 }
+    static Type shiftIn(Type y, float x)
+    {
+        auto shifted = _mm256_permutevar8x32_ps(y, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+        return _mm256_blend_ps(shifted, _mm256_set1_ps(x), 1);
+    }
+    
+    //x = mantissa * 2^exponent with the mantissa in [0.5, 1), for positive normal x
+    static void splitExponent(Type x, Type& mantissa, Type& exponent)
+    {
+        auto bits = _mm256_castps_si256(x);
+        exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                       _mm256_set1_epi32(0x3f000000)));
+    }
+};
+}
+
+const DspKernels* getAVX2Kernels()
+{
+    static const DspKernels kernels { InstructionSet::avx2, "avx2",
+                                      processCascade<AVX2>, processCascadeBlocked<AVX2>, processParallel<AVX2>,
+                                      gainToDecibels<AVX2>, measureLevel<AVX2>, measureTruePeak<AVX2>,
+                                      matrixMidSide<AVX2> };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* getAVX2Kernels() { return nullptr; }
+
+#endif
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    AVX-512 variant of the DSP kernels, see BiquadKernels.h.
+
+  ==============================================================================
+*/
+
+#include "../DspKernels.h"
+
+#if defined(__AVX512F__)
+
+#include "BiquadKernels.h"
+#include <immintrin.h>
+
+namespace
+{
+struct AVX512
+{
+    using Type = __m512;
+    using Mask = __mmask16;
+    static constexpr int width = 16;
+    
+    static Type load(const float* p) { return _mm512_load_ps(p); }
+    static Type loadUnaligned(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, Type v) { _mm512_store_ps(p, v); }
+    static void storeUnaligned(float* p, Type v) { _mm512_storeu_ps(p, v); }
+    static Type broadcast(float v) { return _mm512_set1_ps(v); }
+    
+    static Type add(Type a, Type b) { return _mm512_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm512_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm512_mul_ps(a, b); }
+    static Type max(Type a, Type b) { return _mm512_max_ps(a, b); }
+    
+    static Mask lessThan(Type a, Type b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static Mask atLeast(Type a, Type b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static Type select(Mask m, Type a, Type b) { return _mm512_mask_blend_ps(m, b, a); }
+    
+    static float sum(Type v) { return _mm512_reduce_add_ps(v); }
+    
+    static Type laneIndices() { return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+    
+    static Mask lanesBetween(Type lanes, float first, float last)
+    {
+        auto fromFirst = _mm512_cmp_ps_mask(lanes, _mm512_set1_ps(first), _CMP_GE_OQ);
+        return _mm512_mask_cmp_ps_mask(fromFirst, lanes, _mm512_set1_ps(last), _CMP_LE_OQ);
+    }
+    
+    //{ x, y0, y1, ..., y14 }
+    static Type shiftIn(Type y, float x)
+    {
+        auto shifted = _mm512_permutexvar_ps(_mm512_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14), y);
+        return _mm512_mask_mov_ps(shifted, 1, _mm512_set1_ps(x));
+    }
+    
+    //x = mantissa * 2^exponent with the mantissa in [0.5, 1), for positive normal x
+    static void splitExponent(Type x, Type& mantissa, Type& exponent)
+    {
+        auto bits = _mm512_castps_si512(x);
+        exponent = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(126)));
+        mantissa = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)),
+                                                       _mm512_set1_epi32(0x3f000000)));
+    }
+};
+}
+
+const DspKernels* getAVX512Kernels()
+{
+    static const DspKernels kernels { InstructionSet::avx512, "avx512",
+                                      processCascade<AVX512>, processCascadeBlocked<AVX512>, processParallel<AVX512>,
+                                      gainToDecibels<AVX512>, measureLevel<AVX512>, measureTruePeak<AVX512>,
+                                      matrixMidSide<AVX512> };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* getAVX512Kernels() { return nullptr; }
+
+#endif
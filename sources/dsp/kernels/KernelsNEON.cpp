@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    NEON variant of the DSP kernels, see BiquadKernels.h.
+
+  ==============================================================================
+*/
+
+#include "../DspKernels.h"
+
+//vaddvq_f32() and friends are AArch64 only
+#if (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+
+#include "BiquadKernels.h"
+#include <arm_neon.h>
+
+namespace
+{
+struct NEON
+{
+    using Type = float32x4_t;
+    using Mask = uint32x4_t;
+    static constexpr int width = 4;
+    
+    static Type load(const float* p) { return vld1q_f32(p); }
+    static Type loadUnaligned(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, Type v) { vst1q_f32(p, v); }
+    static void storeUnaligned(float* p, Type v) { vst1q_f32(p, v); }
+    static Type broadcast(float v) { return vdupq_n_f32(v); }
+    
+    static Type add(Type a, Type b) { return vaddq_f32(a, b); }
+    static Type sub(Type a, Type b) { return vsubq_f32(a, b); }
+    static Type mul(Type a, Type b) { return vmulq_f32(a, b); }
+    static Type max(Type a, Type b) { return vmaxq_f32(a, b); }
+    
+    static Mask lessThan(Type a, Type b) { return vcltq_f32(a, b); }
+    static Mask atLeast(Type a, Type b) { return vcgeq_f32(a, b); }
+    static Type select(Mask m, Type a, Type b) { return vbslq_f32(m, a, b); }
+    
+    static float sum(Type v) { return vaddvq_f32(v); }
+    
+    static Type laneIndices()
+    {
+        alignas(16) const float indices[] { 0, 1, 2, 3 };
+        return vld1q_f32(indices);
+    }
+    
+    static Mask lanesBetween(Type lanes, float first, float last)
+    {
+        return vandq_u32(vcgeq_f32(lanes, vdupq_n_f32(first)), vcleq_f32(lanes, vdupq_n_f32(last)));
+    }
+    
+    //{ x, y0, y1, y2 }
+    static Type shiftIn(Type y, float x)
+    {
+        return vextq_f32(vdupq_n_f32(x), y, 3);
+    }
+    
+    //x = mantissa * 2^exponent with the mantissa in [0.5, 1), for positive normal x
+    static void splitExponent(Type x, Type& mantissa, Type& exponent)
+    {
+        auto bits = vreinterpretq_u32_f32(x);
+        exponent = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(126)));
+        mantissa = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)),
+                                                   vdupq_n_u32(0x3f000000)));
+    }
+};
+}
+
+const DspKernels* getNEONKernels()
+{
+    static const DspKernels kernels { InstructionSet::neon, "neon",
+                                      processCascade<NEON>, processCascadeBlocked<NEON>, processParallel<NEON>,
+                                      gainToDecibels<NEON>, measureLevel<NEON>, measureTruePeak<NEON>,
+                                      matrixMidSide<NEON> };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* getNEONKernels() { return nullptr; }
+
+#endif
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    SSE2 variant of the DSP kernels, see BiquadKernels.h.
+
+  ==============================================================================
+*/
+
+#include "../DspKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include "BiquadKernels.h"
+#include <emmintrin.h>
+
+namespace
+{
+struct SSE2
+{
+    using Type = __m128;
+    using Mask = __m128;
+    static constexpr int width = 4;
+    
+    static Type load(const float* p) { return _mm_load_ps(p); }
+    static Type loadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Type v) { _mm_store_ps(p, v); }
+    static void storeUnaligned(float* p, Type v) { _mm_storeu_ps(p, v); }
+    static Type broadcast(float v) { return _mm_set1_ps(v); }
+    
+    static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+    static Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+    static Type max(Type a, Type b) { return _mm_max_ps(a, b); }
+    
+    static Mask lessThan(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+    static Mask atLeast(Type a, Type b) { return _mm_cmpge_ps(a, b); }
+    static Type select(Mask m, Type a, Type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    
+    static float sum(Type v)
+    {
+        auto pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    
+    static Type laneIndices() { return _mm_setr_ps(0, 1, 2, 3); }
+    
+    static Mask lanesBetween(Type lanes, float first, float last)
+    {
+        return _mm_and_ps(_mm_cmpge_ps(lanes, _mm_set1_ps(first)), _mm_cmple_ps(lanes, _mm_set1_ps(last)));
+    }
+    
+    //{ x, y0, y1, y2 }
+    static Type shiftIn(Type y, float x)
+    {
+        return _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4)), _mm_set_ss(x));
+    }
+    
+    //x = mantissa * 2^exponent with the mantissa in [0.5, 1), for positive normal x
+    static void splitExponent(Type x, Type& mantissa, Type& exponent)
+    {
+        auto bits = _mm_castps_si128(x);
+        exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+        mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                                 _mm_set1_epi32(0x3f000000)));
+    }
+};
+}
+
+const DspKernels* getSSE2Kernels()
+{
+    static const DspKernels kernels { InstructionSet::sse2, "sse2",
+                                      processCascade<SSE2>, processCascadeBlocked<SSE2>, processParallel<SSE2>,
+                                      gainToDecibels<SSE2>, measureLevel<SSE2>, measureTruePeak<SSE2>,
+                                      matrixMidSide<SSE2> };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* getSSE2Kernels() { return nullptr; }
+
+#endif
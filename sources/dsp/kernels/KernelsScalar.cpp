@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    Portable scalar variant of the DSP kernels, see BiquadKernels.h.
+
+  ==============================================================================
+*/
+
+#include "../DspKernels.h"
+#include "BiquadKernels.h"
+
+//Without vectors there is nothing to gain from the block form, so both cascades are the recursion
+static void processCascadeBlockedScalar(const BiquadCoefficients* coefficients,
+                                        BlockedSection*,
+                                        BiquadState* states,
+                                        int numSections,
+                                        float* samples,
+                                        int numSamples)
+{
+    processCascadeScalar(coefficients, states, numSections, samples, numSamples);
+}
+
+const DspKernels* getScalarKernels()
+{
+    static const DspKernels kernels { InstructionSet::scalar, "scalar",
+                                      processCascadeScalar, processCascadeBlockedScalar, processParallelScalar,
+                                      gainToDecibelsScalar, measureLevelScalar, measureTruePeakScalar,
+                                      matrixMidSideScalar };
+    return &kernels;
+}
@@ -0,0 +1,425 @@
+/*
+  ==============================================================================
+
+    Realtime safety test for the processor.
+
+    Replaces operator new, malloc and pthread_mutex_lock for the whole program
+    and reports every call made from inside processBlock() with a stack trace.
+    The audio thread is driven like a host drives it: automation between
+    blocks, sample rate changes and state loads, and a message thread that
+    loads states and switches modes while it plays. Fails if anything was
+    reported. The hooks rely on glibc, so this only builds on Linux.
+
+    Afterwards the processor has to play the same impulse response as a fresh one
+    loaded with the same state, which it won't if a change made from two threads at
+    once got lost or left a band designed for the wrong settings.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <thread>
+
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+}
+
+//Only processBlock() is checked: hosts allocate and lock around it, and JUCE's parameter
+//listeners take a lock whichever thread automates them
+static thread_local bool insideProcessBlock = false;
+static std::atomic<int> numViolations { 0 };
+static std::atomic<bool> reportViolations { true };
+static std::atomic<const char*> currentScenario { "" };
+static constexpr int maxReportedViolations = 10;
+
+static void writeError(const char* text)
+{
+    //Not through std::cerr, which may allocate or lock itself
+    juce::ignoreUnused(::write(STDERR_FILENO, text, std::strlen(text)));
+}
+
+static void checkRealtime(const char* call)
+{
+    if (! insideProcessBlock)
+        return;
+
+    //Anything the report calls isn't the processor's doing
+    insideProcessBlock = false;
+
+    if (numViolations++ < maxReportedViolations && reportViolations)
+    {
+        writeError("\n");
+        writeError(call);
+        writeError(" called from processBlock() during ");
+        writeError(currentScenario.load());
+        writeError(":\n");
+
+        void* frames[64];
+        backtrace_symbols_fd(frames, backtrace(frames, 64), STDERR_FILENO);
+    }
+
+    insideProcessBlock = true;
+}
+
+extern "C" void* malloc(size_t size) noexcept
+{
+    checkRealtime("malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept
+{
+    checkRealtime("calloc");
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) noexcept
+{
+    checkRealtime("realloc");
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) noexcept
+{
+    __libc_free(pointer);
+}
+
+using MutexLock = int (*)(pthread_mutex_t*);
+static std::atomic<MutexLock> realMutexLock { nullptr };
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    auto lock = realMutexLock.load();
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<MutexLock>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        realMutexLock = lock;
+    }
+
+    checkRealtime("pthread_mutex_lock");
+    return lock(mutex);
+}
+
+//The default operator delete frees through free() above
+static void* allocate(const char* call, size_t size, size_t alignment = 0)
+{
+    checkRealtime(call);
+    size = juce::jmax(static_cast<size_t>(1), size);
+    return alignment == 0 ? __libc_malloc(size) : __libc_memalign(alignment, size);
+}
+
+void* operator new(size_t size)
+{
+    if (auto* pointer = allocate("operator new", size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (auto* pointer = allocate("operator new[]", size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (auto* pointer = allocate("operator new", size, static_cast<size_t>(alignment)))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    if (auto* pointer = allocate("operator new[]", size, static_cast<size_t>(alignment)))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate("operator new", size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate("operator new[]", size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate("operator new", size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate("operator new[]", size, static_cast<size_t>(alignment));
+}
+
+//==============================================================================
+/** Plays blocks of noise through the processor, checking only what happens inside processBlock() */
+struct AudioThread
+{
+    ZooEQAudioProcessor& processor;
+    juce::Random random { 0x61756469 };
+    juce::AudioBuffer<float> noise { 2, 4096 };
+    juce::MidiBuffer midi;
+
+    void prepare(double sampleRate, int blockSize)
+    {
+        processor.releaseResources();
+        processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+    }
+
+    /** Hosts keep to the block size they prepared with less often than not */
+    void processBlock()
+    {
+        static constexpr int blockSizes[] = { 1, 17, 64, 256, 480, 512, 1024, 4096 };
+        const auto numSamples = blockSizes[random.nextInt(static_cast<int>(std::size(blockSizes)))];
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        juce::AudioBuffer<float> block(noise.getArrayOfWritePointers(), 2, numSamples);
+        process(block);
+    }
+
+    void process(juce::AudioBuffer<float>& block)
+    {
+        insideProcessBlock = true;
+        processor.processBlock(block, midi);
+        insideProcessBlock = false;
+    }
+
+    /** What a host does between blocks when it plays automation */
+    void automate()
+    {
+        auto& parameters = processor.getParameters();
+
+        for (int changes = random.nextInt(4); --changes >= 0; )
+            parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+    }
+};
+
+static void setScenario(const char* name)
+{
+    currentScenario = name;
+    std::cout << name << std::endl;
+}
+
+//Makes sure a call from processBlock() would actually be caught, or the test proves nothing
+static void checkHooks()
+{
+    reportViolations = false;
+    insideProcessBlock = true;
+
+    void* volatile pointer = std::malloc(16);
+    std::free(pointer);
+    int* volatile number = new int(0);
+    delete number;
+    std::mutex mutex;
+    mutex.lock();
+    mutex.unlock();
+
+    insideProcessBlock = false;
+    reportViolations = true;
+
+    if (numViolations.exchange(0) != 3)
+        juce::ConsoleApplication::fail("The malloc, operator new and pthread_mutex_lock hooks aren't being called");
+}
+
+static juce::MemoryBlock getState(ZooEQAudioProcessor& processor)
+{
+    juce::MemoryBlock state;
+    processor.getStateInformation(state);
+    return state;
+}
+
+static juce::MemoryBlock getValueTreeState(ZooEQAudioProcessor& processor)
+{
+    juce::MemoryBlock state;
+    juce::MemoryOutputStream stream(state, false);
+    processor.apvts.copyState().writeToStream(stream);
+    return state;
+}
+
+static void randomise(ZooEQAudioProcessor& processor, juce::Random& random)
+{
+    for (auto* parameter : processor.getParameters())
+        parameter->setValueNotifyingHost(random.nextFloat());
+}
+
+/** Plays silence until the filters have rung out, then an impulse */
+static juce::AudioBuffer<float> getImpulseResponse(AudioThread& audio)
+{
+    juce::AudioBuffer<float> block(2, 256);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        block.clear();
+        audio.process(block);
+    }
+
+    juce::AudioBuffer<float> response(2, 16384);
+    response.clear();
+    response.setSample(0, 0, 1.f);
+    response.setSample(1, 0, 1.f);
+
+    for (int offset = 0; offset < response.getNumSamples(); offset += block.getNumSamples())
+    {
+        juce::AudioBuffer<float> part(response.getArrayOfWritePointers(), 2, offset, block.getNumSamples());
+        audio.process(part);
+    }
+
+    return response;
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    return juce::ConsoleApplication::invokeCatchingFailures([]
+    {
+        //The first backtrace() loads the unwinder, which allocates
+        void* frames[1];
+        backtrace(frames, 1);
+        checkHooks();
+
+        ZooEQAudioProcessor processor;
+        AudioThread audio { processor };
+        juce::Random random(0x73746174);
+
+        //States to load that differ from the defaults and from each other
+        randomise(processor, random);
+        const auto binaryState = getState(processor);
+        randomise(processor, random);
+        processor.captureMorphSnapshot(0);
+        randomise(processor, random);
+        processor.captureMorphSnapshot(1);
+        const auto morphState = getState(processor);
+        const auto valueTreeState = getValueTreeState(processor);
+        processor.setStateInformation(binaryState.getData(), static_cast<int>(binaryState.getSize()));
+
+        std::thread([&]
+        {
+            setScenario("host automation");
+            audio.prepare(48000, 512);
+
+            for (int block = 0; block < 3000; ++block)
+            {
+                audio.automate();
+                audio.processBlock();
+            }
+
+            //Hosts stop processing to change the sample rate or load a session, so these run in between
+            setScenario("sample rate changes and state loads");
+            for (auto sampleRate : { 44100.0, 96000.0, 22050.0, 192000.0, 48000.0 })
+                for (auto* state : { &binaryState, &morphState, &valueTreeState })
+                {
+                    audio.prepare(sampleRate, 256);
+                    processor.setStateInformation(state->getData(), static_cast<int>(state->getSize()));
+
+                    for (int block = 0; block < 100; ++block)
+                    {
+                        audio.automate();
+                        audio.processBlock();
+                    }
+                }
+        }).join();
+
+        //Everything the editor can change while the audio plays, from the message thread
+        setScenario("message thread changes");
+        //The host keeps automating meanwhile, so both threads change parameters at once
+        std::atomic<bool> playing { true }, automating { true };
+        std::thread audioThread([&audio, &playing, &automating]
+        {
+            while (playing)
+            {
+                if (automating)
+                    audio.automate();
+
+                audio.processBlock();
+            }
+        });
+
+        for (int change = 0; change < 2000; ++change)
+        {
+            switch (random.nextInt(10))
+            {
+                case 0: processor.setStateInformation(binaryState.getData(), static_cast<int>(binaryState.getSize())); break;
+                case 1: processor.setStateInformation(morphState.getData(), static_cast<int>(morphState.getSize())); break;
+                case 2: processor.setStateInformation(valueTreeState.getData(), static_cast<int>(valueTreeState.getSize())); break;
+                case 3: processor.clearMorphSnapshots(); break;
+                case 4: processor.setFilterEngine(false, static_cast<FilterEngine>(random.nextInt(3))); break;
+                case 5: processor.setFilterTopology(random.nextBool() ? FilterTopology::parallel : FilterTopology::series); break;
+                case 6: processor.setLoudnessCompensation(random.nextBool()); break;
+                case 7: processor.storeCompareSlot(random.nextInt(4)); break;
+                case 8: processor.selectCompareSlot(random.nextInt(5) - 1); break;
+                default: randomise(processor, random); break;
+            }
+
+            juce::Thread::sleep(1);
+        }
+
+        //Ends on a known state, loaded while it still plays
+        automating = false;
+        ZooEQAudioProcessor reference;
+        processor.setFilterEngine(false, reference.getFilterEngine(false));
+        processor.setFilterTopology(reference.getFilterTopology());
+        processor.setLoudnessCompensation(false);
+        processor.selectCompareSlot(CompareSlots::live);
+        processor.setStateInformation(valueTreeState.getData(), static_cast<int>(valueTreeState.getSize()));
+        juce::Thread::sleep(200);
+
+        playing = false;
+        audioThread.join();
+
+        if (numViolations > 0)
+            juce::ConsoleApplication::fail(juce::String(numViolations.load()) + " calls that can block the audio thread were made from processBlock()");
+
+        std::cout << "processBlock() didn't allocate or lock" << std::endl;
+
+        setScenario("comparing with a fresh processor");
+        AudioThread referenceAudio { reference };
+        referenceAudio.prepare(48000, 256);
+        reference.setStateInformation(valueTreeState.getData(), static_cast<int>(valueTreeState.getSize()));
+
+        const auto expected = getImpulseResponse(referenceAudio);
+        const auto played = getImpulseResponse(audio);
+        auto maxDifference = 0.f;
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < expected.getNumSamples(); ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(played.getSample(channel, i) - expected.getSample(channel, i)));
+
+        //Only rounding differences are allowed for, a band left on other settings is far off
+        if (maxDifference > 1.0e-4f)
+            juce::ConsoleApplication::fail("After the changes the impulse response is off by " + juce::String(maxDifference)
+                                           + ": a parameter change was lost or a band wasn't redesigned");
+
+        std::cout << "The processor ended up playing its state" << std::endl;
+        return 0;
+    });
+}
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+    Response regression test. Runs the response checks the benchmarks have,
+    against the golden responses in tests/golden or the processor's own
+    MonoChain, see ResponseCheck.h.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ResponseCheck.h"
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        if (! isResponseCheckRequested(args))
+            juce::ConsoleApplication::fail("Usage: myEQResponseTests [--check-responses <file>] [--write-responses <file>] [--bit-exact] [--kernels <name>] [--engine <name>] [--topology <name>]");
+
+        return runResponseChecks(args);
+    });
+}